@@ -1,7 +1,14 @@
 ﻿// Copyright 2020, Bradley Peterson, Weber State University, All rights reserved.
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <cstdio> // is this used?
 #include <iostream>
+#include <new>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 using std::cerr; // is this used?
 using std::cin;
@@ -39,35 +46,62 @@ protected:
  * Write your code below here *
  ******************************/
 
+// FIXED keeps the original assignment behavior: a push onto a full stack is refused.
+// GEOMETRIC doubles the capacity instead, so push is amortized O(1) and nothing is dropped.
+enum class StackGrowth { FIXED, GEOMETRIC };
+
 template <typename T>
 class StackForCS2420 : public BaseStack<T> {
 public:
-  StackForCS2420(const unsigned int size);
+  StackForCS2420(const unsigned int size, const StackGrowth growth = StackGrowth::FIXED);
   ~StackForCS2420();
+  StackForCS2420(const StackForCS2420<T>&) = delete;
+  StackForCS2420<T>& operator=(const StackForCS2420<T>&) = delete;
   unsigned int size() const;
-  void push(const T& item);
+  unsigned int getCapacity() const;
+  unsigned int max_size() const;
+  bool push(const T& item);
+  bool push(T&& item);
+  template <typename... Args>
+  bool emplace(Args&&... args);
   void pop();
   T top() const;
   void popSecondFromTop();
-  void pushUnderTop(const T& item);
+  bool pushUnderTop(const T& item);
   T topSecondFromTop() const;
+  bool rotate(const unsigned int k);
+  bool insertAt(const unsigned int depthFromTop, const T& item);
+  bool insertAt(const unsigned int depthFromTop, T&& item);
+  void reserve(const unsigned int newCapacity);
+  void shrink_to_fit();
 
 private:
+  bool makeRoom();
+  template <typename U>
+  bool insertAtDepth(const unsigned int depthFromTop, U&& item);
+  void reallocate(const unsigned int newCapacity);
+
   unsigned int index{ 0 };
   unsigned int capacity{ 0 };
+  StackGrowth growth{ StackGrowth::FIXED };
+  // Raw storage, only slots [0, index) hold constructed objects.
   T* arr{ nullptr };
 };
 
 template <typename T>
-StackForCS2420<T>::StackForCS2420(const unsigned int size) {
+StackForCS2420<T>::StackForCS2420(const unsigned int size, const StackGrowth growth) {
   this->index = 0;
-  this->capacity = size;
-  this->arr = new T[size];
+  this->capacity = 0;
+  this->growth = growth;
+  this->reallocate(size);
 }
 
 template <typename T>
 StackForCS2420<T>::~StackForCS2420() {
-  delete[] arr;
+  while (this->index > 0) {
+    this->pop();
+  }
+  ::operator delete(this->arr);
 }
 
 template <typename T>
@@ -76,17 +110,91 @@ unsigned int StackForCS2420<T>::size() const {
 }
 
 template <typename T>
-void StackForCS2420<T>::push(const T& item) {
+unsigned int StackForCS2420<T>::getCapacity() const {
+  return this->capacity;
+}
+
+// The most items the stack can ever hold: the capacity is an unsigned int, and the storage
+// for all of them has to be countable in bytes.
+template <typename T>
+unsigned int StackForCS2420<T>::max_size() const {
+  return SIZE_MAX / sizeof(T) < UINT_MAX ? static_cast<unsigned int>(SIZE_MAX / sizeof(T)) : UINT_MAX;
+}
+
+// Makes sure there is a free slot on top, growing the storage if allowed.
+// Doubling stops at max_size() instead of wrapping around to a smaller capacity.
+template <typename T>
+bool StackForCS2420<T>::makeRoom() {
+  if (this->index < this->capacity) {
+    return true;
+  }
+  if (this->growth == StackGrowth::FIXED || this->capacity == this->max_size()) {
+    return false;
+  }
+  if (this->capacity == 0) {
+    this->reallocate(1);
+  } else {
+    this->reallocate(this->capacity > this->max_size() / 2 ? this->max_size() : this->capacity * 2);
+  }
+  return true;
+}
+
+// Moves the live elements into a fresh block of exactly newCapacity slots.
+template <typename T>
+void StackForCS2420<T>::reallocate(const unsigned int newCapacity) {
+  if (newCapacity > this->max_size()) {
+    throw std::length_error("StackForCS2420: capacity is larger than max_size()");
+  }
+  T* newArr = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+  for (unsigned int i = 0; i < this->index; i++) {
+    new (&newArr[i]) T(std::move_if_noexcept(this->arr[i]));
+    this->arr[i].~T();
+  }
+  ::operator delete(this->arr);
+  this->arr = newArr;
+  this->capacity = newCapacity;
+}
+
+template <typename T>
+void StackForCS2420<T>::reserve(const unsigned int newCapacity) {
+  if (newCapacity > this->capacity) {
+    this->reallocate(newCapacity);
+  }
+}
+
+template <typename T>
+void StackForCS2420<T>::shrink_to_fit() {
   if (this->index < this->capacity) {
-    this->arr[this->index] = item;
-    this->index++;
+    this->reallocate(this->index);
   }
 }
 
+template <typename T>
+bool StackForCS2420<T>::push(const T& item) {
+  return this->emplace(item);
+}
+
+template <typename T>
+bool StackForCS2420<T>::push(T&& item) {
+  return this->emplace(std::move(item));
+}
+
+template <typename T>
+template <typename... Args>
+bool StackForCS2420<T>::emplace(Args&&... args) {
+  if (!this->makeRoom()) {
+    return false;
+  }
+  new (&this->arr[this->index]) T(std::forward<Args>(args)...);
+  this->index++;
+  return true;
+}
+
 template <typename T>
 void StackForCS2420<T>::pop() {
   if (this->index > 0) {
     this->index--;
+    this->arr[this->index].~T();
   } else {
     return;
   }
@@ -101,24 +209,18 @@ T StackForCS2420<T>::top() const {
   }
 }
 
+// Moves the top item into the second slot, so nothing is copied.
 template <typename T>
 void StackForCS2420<T>::popSecondFromTop() {
-  if (this->index >= 1) {
-    T tmp = this->top();
+  if (this->index >= 2) {
+    this->arr[this->index - 2] = std::move(this->arr[this->index - 1]);
     this->pop();
-    this->pop();
-    this->push(tmp);
   }
 }
 
 template <typename T>
-void StackForCS2420<T>::pushUnderTop(const T& item) {
-  if (this->index >= 1 && this->index <= this->capacity) {
-    T tmp = this->top();
-    this->pop();
-    this->push(item);
-    this->push(tmp);
-  }
+bool StackForCS2420<T>::pushUnderTop(const T& item) {
+  return this->insertAt(1, item);
 }
 
 template <typename T>
@@ -130,6 +232,54 @@ T StackForCS2420<T>::topSecondFromTop() const {
   }
 }
 
+// Brings the item k - 1 below the top up to the top, and the k - 1 items above it each move down one.
+// rotate(2) swaps the top two items.
+template <typename T>
+bool StackForCS2420<T>::rotate(const unsigned int k) {
+  if (k > this->index) {
+    return false;
+  }
+  if (k > 1) {
+    T* bottom = this->arr + (this->index - k);
+    std::rotate(bottom, bottom + 1, this->arr + this->index);
+  }
+  return true;
+}
+
+// Places the item underneath the top depthFromTop items.  insertAt(0, item) is a plain push.
+template <typename T>
+bool StackForCS2420<T>::insertAt(const unsigned int depthFromTop, const T& item) {
+  return this->insertAtDepth(depthFromTop, item);
+}
+
+template <typename T>
+bool StackForCS2420<T>::insertAt(const unsigned int depthFromTop, T&& item) {
+  return this->insertAtDepth(depthFromTop, std::move(item));
+}
+
+template <typename T>
+template <typename U>
+bool StackForCS2420<T>::insertAtDepth(const unsigned int depthFromTop, U&& item) {
+  if (depthFromTop > this->index) {
+    return false;
+  }
+  if (depthFromTop == 0) {
+    return this->emplace(std::forward<U>(item));
+  }
+  if (this->index == this->capacity && (this->growth == StackGrowth::FIXED || this->capacity == this->max_size())) {
+    return false;
+  }
+  // The item may be one of our own slots, so take it out before anything shifts.
+  T value(std::forward<U>(item));
+  this->makeRoom();
+  // Open a slot at the insertion depth by moving the items above it up one.
+  new (&this->arr[this->index]) T(std::move(this->arr[this->index - 1]));
+  std::move_backward(this->arr + (this->index - depthFromTop), this->arr + (this->index - 1), this->arr + this->index);
+  this->arr[this->index - depthFromTop] = std::move(value);
+  this->index++;
+  return true;
+}
+
 /******************************
  * Write your code above here *
  ******************************/
@@ -412,6 +562,175 @@ void testStackAdditional() {
   }
 }
 
+void testStackGrowth() {
+  {
+    // A fixed stack reports the refused push instead of dropping it silently.
+    StackForCS2420<int> stack(2);
+    stack.push(1);
+    stack.push(2);
+    checkTest("testStackGrowth #1", false, stack.push(3));
+    checkTest("testStackGrowth #2", 2, stack.top());
+    checkTest("testStackGrowth #3", 2, stack.getCapacity());
+  }
+  {
+    // A geometric stack keeps everything.
+    StackForCS2420<int> stack(2, StackGrowth::GEOMETRIC);
+    for (int i = 0; i < 100; i++) {
+      stack.push(i);
+    }
+    checkTest("testStackGrowth #4", 100, stack.size());
+    checkTest("testStackGrowth #5", 128, stack.getCapacity());
+    checkTest("testStackGrowth #6", 99, stack.top());
+    checkTest("testStackGrowth #7", 98, stack.topSecondFromTop());
+
+    for (int i = 0; i < 90; i++) {
+      stack.pop();
+    }
+    stack.shrink_to_fit();
+    checkTest("testStackGrowth #8", 10, stack.getCapacity());
+    checkTest("testStackGrowth #9", 9, stack.top());
+
+    stack.reserve(50);
+    checkTest("testStackGrowth #10", 50, stack.getCapacity());
+    checkTest("testStackGrowth #11", 10, stack.size());
+  }
+  {
+    // Strings survive the reallocations, and can be moved or built in place.
+    StackForCS2420<string> sstack(0, StackGrowth::GEOMETRIC);
+    string pen = "pen";
+    sstack.push(pen);
+    sstack.push(std::move(pen));
+    sstack.emplace(3, 'x');
+    sstack.push("marker");
+    checkTest("testStackGrowth #12", 4, sstack.size());
+    checkTest("testStackGrowth #13", "marker", sstack.top());
+    sstack.pop();
+    checkTest("testStackGrowth #14", "xxx", sstack.top());
+    sstack.pop();
+    checkTest("testStackGrowth #15", "pen", sstack.top());
+    sstack.pop();
+    checkTest("testStackGrowth #16", "pen", sstack.top());
+  }
+}
+
+void testStackDeepEdits() {
+  {
+    StackForCS2420<int> stack(10);
+    for (int i = 1; i <= 5; i++) {
+      stack.push(i);
+    }
+    // 1 2 3 4 5 becomes 1 2 4 5 3
+    stack.rotate(3);
+    checkTest("testStackDeepEdits #1", 3, stack.top());
+    checkTest("testStackDeepEdits #2", 5, stack.topSecondFromTop());
+    // 1 2 4 5 3 becomes 1 2 4 3 5
+    stack.rotate(2);
+    checkTest("testStackDeepEdits #3", 5, stack.top());
+    checkTest("testStackDeepEdits #4", false, stack.rotate(6));
+    checkTest("testStackDeepEdits #5", 5, stack.top());
+
+    // 1 2 4 3 5 becomes 1 2 9 4 3 5
+    stack.insertAt(3, 9);
+    checkTest("testStackDeepEdits #6", 6, stack.size());
+    stack.pop();
+    stack.pop();
+    stack.pop();
+    checkTest("testStackDeepEdits #7", 9, stack.top());
+    checkTest("testStackDeepEdits #8", false, stack.insertAt(4, 7));
+    stack.insertAt(3, 7);
+    checkTest("testStackDeepEdits #9", 4, stack.size());
+    stack.pop();
+    stack.pop();
+    stack.pop();
+    checkTest("testStackDeepEdits #10", 7, stack.top());
+  }
+  {
+    // A full fixed stack refuses pushUnderTop instead of losing the top.
+    StackForCS2420<string> sstack(2);
+    sstack.push("pencil");
+    sstack.push("pen");
+    checkTest("testStackDeepEdits #11", false, sstack.pushUnderTop("marker"));
+    checkTest("testStackDeepEdits #12", "pen", sstack.top());
+    sstack.popSecondFromTop();
+    checkTest("testStackDeepEdits #13", "pen", sstack.top());
+    checkTest("testStackDeepEdits #14", 1, sstack.size());
+  }
+  {
+    // Inserting a copy of the top item (top() returns by value) while the stack grows.
+    StackForCS2420<string> sstack(3, StackGrowth::GEOMETRIC);
+    sstack.push("a");
+    sstack.push("b");
+    sstack.push("c");
+    sstack.pushUnderTop(sstack.top());
+    checkTest("testStackDeepEdits #15", "c", sstack.top());
+    checkTest("testStackDeepEdits #16", "c", sstack.topSecondFromTop());
+    checkTest("testStackDeepEdits #17", 4, sstack.size());
+  }
+}
+
+// The 256 byte plain old data payload used by the benchmark.
+struct Block {
+  char bytes[256];
+};
+
+// The original popSecondFromTop() and pushUnderTop(), which round trip the top item through a copy.
+template <typename T>
+void popSecondFromTopByCopy(StackForCS2420<T>& stack) {
+  if (stack.size() >= 1) {
+    T tmp = stack.top();
+    stack.pop();
+    stack.pop();
+    stack.push(tmp);
+  }
+}
+
+template <typename T>
+void pushUnderTopByCopy(StackForCS2420<T>& stack, const T& item) {
+  if (stack.size() >= 1) {
+    T tmp = stack.top();
+    stack.pop();
+    stack.push(item);
+    stack.push(tmp);
+  }
+}
+
+template <typename T>
+double timeStackEdits(const T& item, const bool byCopy) {
+  const int rounds = 1000000;
+  StackForCS2420<T> stack(1000);
+  for (int i = 0; i < 999; i++) {
+    stack.push(item);
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    if (byCopy) {
+      pushUnderTopByCopy(stack, item);
+      popSecondFromTopByCopy(stack);
+    } else {
+      stack.pushUnderTop(item);
+      stack.popSecondFromTop();
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return diff.count() / 1000.0;
+}
+
+template <typename T>
+void benchmarkStackEdits(const string& label, const T& item) {
+  double copyTime = timeStackEdits(item, true);
+  double moveTime = timeStackEdits(item, false);
+  cout << "    " << label << ": 1,000,000 pushUnderTop + popSecondFromTop pairs took " << copyTime
+       << " milliseconds by copy, " << moveTime << " milliseconds in place." << endl;
+}
+
+void benchmarkStackDeepEdits() {
+  cout << "Benchmarking popSecondFromTop and pushUnderTop against the original top-copy round trip." << endl;
+  benchmarkStackEdits("std::string", string(64, 's'));
+  Block block{};
+  benchmarkStackEdits("256 byte POD", block);
+}
+
 void pressAnyKeyToContinue() {
   cout << "Press enter to continue...";
 
@@ -426,6 +745,11 @@ int main() {
     pressAnyKeyToContinue();
     testStackAdditional();
     pressAnyKeyToContinue();
+    testStackGrowth();
+    pressAnyKeyToContinue();
+    testStackDeepEdits();
+    benchmarkStackDeepEdits();
+    pressAnyKeyToContinue();
   }
   cout << "Shutting down the program" << endl;
   return 0;
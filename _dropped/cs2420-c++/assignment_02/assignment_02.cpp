@@ -1,7 +1,17 @@
 // Copyright 2020, Bradley Peterson, Weber State University, All rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 using std::cerr;
@@ -65,36 +75,106 @@ protected:
 //**********************************
 // Write your code below here
 //**********************************
+
+// What try_push and try_pop report back instead of printing or throwing.
+enum class QueueStatus { OK, FULL, EMPTY };
+
+// Diagnostics hooks for QueueForCS2420, called when a push_back, pop_front, front or back
+// runs into a full or empty queue.  The default does nothing, so the calls compile away.
+struct SilentQueueDiagnostics {
+  static void onFull() {}
+  static void onEmpty() {}
+};
+
+// Prints the messages the queue used to print itself.
+struct ConsoleQueueDiagnostics {
+  static void onFull() { cout << "The queue is full" << endl; }
+  static void onEmpty() { cout << "The queue is empty" << endl; }
+};
+
+// A run of items that sit next to each other in a queue's buffer.
 template <typename T>
+struct QueueSpan {
+  T* data{ nullptr };
+  unsigned int size{ 0 };
+  T* begin() const { return data; }
+  T* end() const { return data + size; }
+};
+
+// How a QueueForCS2420 may resize itself.  By default it never does, and a push onto a full
+// queue is refused like in the original assignment.
+struct QueueGrowthPolicy {
+  // Double the capacity instead of refusing a push onto a full queue.
+  bool grow{ false };
+  // The most slots growing may reach, 0 for no limit.  Past it pushes are refused again.
+  unsigned int highWaterMark{ 0 };
+  // Halve the capacity once the queue is down to a quarter full, but never below the starting capacity.
+  bool shrink{ false };
+};
+
+// Counters for tuning the starting capacity and high-water mark.
+struct QueueStats {
+  unsigned int growths{ 0 };
+  unsigned int shrinks{ 0 };
+  unsigned int peakCapacity{ 0 };
+  unsigned int peakItems{ 0 };
+};
+
+template <typename T, typename Diagnostics = SilentQueueDiagnostics>
 class QueueForCS2420 : public BaseQueue<T> {
 public:
-  QueueForCS2420(const unsigned int);
+  QueueForCS2420(const unsigned int, const QueueGrowthPolicy& = QueueGrowthPolicy());
   QueueForCS2420(QueueForCS2420&&);
   ~QueueForCS2420();
-  QueueForCS2420<T>& operator=(QueueForCS2420&&);
+  QueueForCS2420& operator=(QueueForCS2420&&);
   const unsigned int numItems() const;
   void push_back(const T&);
+  void push_back(T&&);
   void pop_front();
+  bool pop_front(T&);
+  QueueStatus try_push(const T&);
+  QueueStatus try_push(T&&);
+  QueueStatus try_pop(T&);
+  unsigned int push_back_n(const T*, const unsigned int);
+  unsigned int pop_front_n(T*, const unsigned int);
+  unsigned int pop_front_n(const unsigned int);
+  QueueSpan<const T> peek_contiguous() const;
   T front();
   T back();
+  unsigned int getCapacity() const;
+  QueueStats getStats() const;
 
 private:
+  template <typename U>
+  void store_back(U&& item);
+  bool growFor(const unsigned int extra);
+  void shrinkIfSparse();
+  void resize(const unsigned int newCapacity);
+  static void copySlots(T* to, const T* from, const unsigned int n);
+  static void moveSlots(T* to, T* from, const unsigned int n);
+
   int capacity{ 0 };
   int size{ 0 };
   int head{ 0 };
   int tail{ 0 };
+  int minCapacity{ 0 };
+  QueueGrowthPolicy policy;
+  QueueStats stats;
 
   T* arr{ nullptr };
 };
 
-template <typename T>
-QueueForCS2420<T>::QueueForCS2420(const unsigned int capacity) {
+template <typename T, typename Diagnostics>
+QueueForCS2420<T, Diagnostics>::QueueForCS2420(const unsigned int capacity, const QueueGrowthPolicy& policy) {
   this->capacity = capacity;
+  this->minCapacity = capacity;
+  this->policy = policy;
+  this->stats.peakCapacity = capacity;
   this->arr = new T[capacity];
 }
 
-template <typename T>
-QueueForCS2420<T>::QueueForCS2420(QueueForCS2420&& other) {
+template <typename T, typename Diagnostics>
+QueueForCS2420<T, Diagnostics>::QueueForCS2420(QueueForCS2420&& other) {
   this->capacity = other.capacity;
   other.capacity = 0;
   this->size = other.size;
@@ -103,17 +183,20 @@ QueueForCS2420<T>::QueueForCS2420(QueueForCS2420&& other) {
   other.head = 0;
   this->tail = other.tail;
   other.tail = 0;
+  this->minCapacity = other.minCapacity;
+  this->policy = other.policy;
+  this->stats = other.stats;
   this->arr = other.arr;
   other.arr = nullptr;
 }
 
-template <typename T>
-QueueForCS2420<T>::~QueueForCS2420() {
+template <typename T, typename Diagnostics>
+QueueForCS2420<T, Diagnostics>::~QueueForCS2420() {
   delete[] this->arr;
 }
 
-template <typename T>
-QueueForCS2420<T>& QueueForCS2420<T>::operator=(QueueForCS2420&& other) {
+template <typename T, typename Diagnostics>
+QueueForCS2420<T, Diagnostics>& QueueForCS2420<T, Diagnostics>::operator=(QueueForCS2420&& other) {
   if (this->arr) {
     delete[] this->arr;
   }
@@ -125,35 +208,136 @@ QueueForCS2420<T>& QueueForCS2420<T>::operator=(QueueForCS2420&& other) {
   other.head = 0;
   this->tail = other.tail;
   other.tail = 0;
+  this->minCapacity = other.minCapacity;
+  this->policy = other.policy;
+  this->stats = other.stats;
   this->arr = other.arr;
   other.arr = nullptr;
 
   return *this;
 }
 
-template <typename T>
-const unsigned int QueueForCS2420<T>::numItems() const {
+template <typename T, typename Diagnostics>
+const unsigned int QueueForCS2420<T, Diagnostics>::numItems() const {
   return this->size;
 }
 
-template <typename T>
-void QueueForCS2420<T>::push_back(const T& item) {
-  if (this->size == this->capacity) {
-    cout << "The queue is full" << endl;
-    return;
-  }
+// Puts the item in the next slot, the caller has already checked there is room.
+template <typename T, typename Diagnostics>
+template <typename U>
+void QueueForCS2420<T, Diagnostics>::store_back(U&& item) {
   if (this->tail == this->capacity) {
     this->tail = 0;
   }
-  this->arr[this->tail] = item;
+  this->arr[this->tail] = std::forward<U>(item);
   this->size++;
   this->tail++;
+  if (static_cast<unsigned int>(this->size) > this->stats.peakItems) {
+    this->stats.peakItems = this->size;
+  }
 }
 
-template <typename T>
-void QueueForCS2420<T>::pop_front() {
+// Tries to make room for `extra` more items under the growth policy, and returns whether it did.
+template <typename T, typename Diagnostics>
+bool QueueForCS2420<T, Diagnostics>::growFor(const unsigned int extra) {
+  if (!this->policy.grow) {
+    return false;
+  }
+  unsigned int needed = this->size + extra;
+  unsigned int limit = this->policy.highWaterMark;
+  if (limit != 0 && needed > limit) {
+    needed = limit;
+  }
+  if (needed <= static_cast<unsigned int>(this->capacity)) {
+    return false;
+  }
+  unsigned int newCapacity = this->capacity == 0 ? 1 : this->capacity * 2;
+  if (newCapacity < needed) {
+    newCapacity = needed;
+  }
+  if (limit != 0 && newCapacity > limit) {
+    newCapacity = limit;
+  }
+  this->resize(newCapacity);
+  this->stats.growths++;
+  if (newCapacity > this->stats.peakCapacity) {
+    this->stats.peakCapacity = newCapacity;
+  }
+  return true;
+}
+
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::shrinkIfSparse() {
+  if (!this->policy.shrink || this->size * 4 > this->capacity) {
+    return;
+  }
+  int newCapacity = this->capacity;
+  while (this->size * 4 <= newCapacity && newCapacity > this->minCapacity && newCapacity > 1) {
+    newCapacity = newCapacity / 2 > this->minCapacity ? newCapacity / 2 : this->minCapacity;
+  }
+  if (newCapacity != this->capacity) {
+    this->resize(newCapacity);
+    this->stats.shrinks++;
+  }
+}
+
+// Moves the items into a new array of newCapacity slots, unwrapping the ring so the front lands in slot 0.
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::resize(const unsigned int newCapacity) {
+  T* newArr = new T[newCapacity];
+  unsigned int firstRun = this->capacity - this->head;
+  if (firstRun > static_cast<unsigned int>(this->size)) {
+    firstRun = this->size;
+  }
+  moveSlots(newArr, this->arr + this->head, firstRun);
+  moveSlots(newArr + firstRun, this->arr, this->size - firstRun);
+  delete[] this->arr;
+  this->arr = newArr;
+  this->capacity = newCapacity;
+  this->head = 0;
+  this->tail = this->size;
+}
+
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::push_back(const T& item) {
+  if (this->size == this->capacity && !this->growFor(1)) {
+    Diagnostics::onFull();
+    return;
+  }
+  this->store_back(item);
+}
+
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::push_back(T&& item) {
+  if (this->size == this->capacity && !this->growFor(1)) {
+    Diagnostics::onFull();
+    return;
+  }
+  this->store_back(std::move(item));
+}
+
+template <typename T, typename Diagnostics>
+QueueStatus QueueForCS2420<T, Diagnostics>::try_push(const T& item) {
+  if (this->size == this->capacity && !this->growFor(1)) {
+    return QueueStatus::FULL;
+  }
+  this->store_back(item);
+  return QueueStatus::OK;
+}
+
+template <typename T, typename Diagnostics>
+QueueStatus QueueForCS2420<T, Diagnostics>::try_push(T&& item) {
+  if (this->size == this->capacity && !this->growFor(1)) {
+    return QueueStatus::FULL;
+  }
+  this->store_back(std::move(item));
+  return QueueStatus::OK;
+}
+
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::pop_front() {
   if (this->size == 0) {
-    cout << "The queue is empty" << endl;
+    Diagnostics::onEmpty();
     return;
   }
   this->head++;
@@ -161,28 +345,465 @@ void QueueForCS2420<T>::pop_front() {
     this->head = 0;
   }
   this->size--;
+  this->shrinkIfSparse();
 }
 
-template <typename T>
-T QueueForCS2420<T>::front() {
+// Moves the front item out into `item` and then pops it.
+template <typename T, typename Diagnostics>
+bool QueueForCS2420<T, Diagnostics>::pop_front(T& item) {
+  if (this->size == 0) {
+    Diagnostics::onEmpty();
+    return false;
+  }
+  item = std::move(this->arr[this->head]);
+  this->pop_front();
+  return true;
+}
+
+template <typename T, typename Diagnostics>
+QueueStatus QueueForCS2420<T, Diagnostics>::try_pop(T& item) {
   if (this->size == 0) {
-    cout << "The queue is empty" << endl;
+    return QueueStatus::EMPTY;
+  }
+  item = std::move(this->arr[this->head]);
+  this->pop_front();
+  return QueueStatus::OK;
+}
+
+// The batch operations below work on at most two runs of slots, the one up to the end of
+// the array and the one that wraps around to the start.
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::copySlots(T* to, const T* from, const unsigned int n) {
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    std::memcpy(to, from, n * sizeof(T));
+  } else {
+    std::copy(from, from + n, to);
+  }
+}
+
+template <typename T, typename Diagnostics>
+void QueueForCS2420<T, Diagnostics>::moveSlots(T* to, T* from, const unsigned int n) {
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    std::memcpy(to, from, n * sizeof(T));
+  } else {
+    std::move(from, from + n, to);
+  }
+}
+
+// Copies in as many of the n items as there is room for, and returns how many went in.
+// The items must not point into this queue, since growing moves its buffer.
+template <typename T, typename Diagnostics>
+unsigned int QueueForCS2420<T, Diagnostics>::push_back_n(const T* items, const unsigned int n) {
+  if (n > static_cast<unsigned int>(this->capacity - this->size)) {
+    this->growFor(n);
+  }
+  unsigned int room = this->capacity - this->size;
+  unsigned int count = n < room ? n : room;
+  if (count == 0) {
+    return 0;
+  }
+  if (this->tail == this->capacity) {
+    this->tail = 0;
+  }
+  unsigned int firstRun = this->capacity - this->tail;
+  if (firstRun > count) {
+    firstRun = count;
+  }
+  copySlots(this->arr + this->tail, items, firstRun);
+  copySlots(this->arr, items + firstRun, count - firstRun);
+  this->tail += count;
+  if (this->tail > this->capacity) {
+    this->tail -= this->capacity;
+  }
+  this->size += count;
+  if (static_cast<unsigned int>(this->size) > this->stats.peakItems) {
+    this->stats.peakItems = this->size;
+  }
+  return count;
+}
+
+// Moves up to n items out of the front, and returns how many came out.
+template <typename T, typename Diagnostics>
+unsigned int QueueForCS2420<T, Diagnostics>::pop_front_n(T* items, const unsigned int n) {
+  unsigned int count = n < static_cast<unsigned int>(this->size) ? n : this->size;
+  unsigned int firstRun = this->capacity - this->head;
+  if (firstRun > count) {
+    firstRun = count;
+  }
+  moveSlots(items, this->arr + this->head, firstRun);
+  moveSlots(items + firstRun, this->arr, count - firstRun);
+  return this->pop_front_n(count);
+}
+
+// Drops up to n items from the front without reading them, for use after peek_contiguous().
+template <typename T, typename Diagnostics>
+unsigned int QueueForCS2420<T, Diagnostics>::pop_front_n(const unsigned int n) {
+  unsigned int count = n < static_cast<unsigned int>(this->size) ? n : this->size;
+  this->head += count;
+  if (this->head >= this->capacity) {
+    this->head -= this->capacity;
+  }
+  this->size -= count;
+  this->shrinkIfSparse();
+  return count;
+}
+
+// The items from the front up to the end of the array or the back, whichever comes first.
+template <typename T, typename Diagnostics>
+QueueSpan<const T> QueueForCS2420<T, Diagnostics>::peek_contiguous() const {
+  QueueSpan<const T> span;
+  span.data = this->arr + this->head;
+  span.size = this->capacity - this->head;
+  if (span.size > static_cast<unsigned int>(this->size)) {
+    span.size = this->size;
+  }
+  return span;
+}
+
+template <typename T, typename Diagnostics>
+unsigned int QueueForCS2420<T, Diagnostics>::getCapacity() const {
+  return this->capacity;
+}
+
+template <typename T, typename Diagnostics>
+QueueStats QueueForCS2420<T, Diagnostics>::getStats() const {
+  return this->stats;
+}
+
+template <typename T, typename Diagnostics>
+T QueueForCS2420<T, Diagnostics>::front() {
+  if (this->size == 0) {
+    Diagnostics::onEmpty();
     throw 1;
   }
-  cout << "Head: " << this->arr[this->head] << endl;
   return this->arr[this->head];
 }
 
-template <typename T>
-T QueueForCS2420<T>::back() {
+template <typename T, typename Diagnostics>
+T QueueForCS2420<T, Diagnostics>::back() {
   if (this->size == 0) {
-    cout << "The queue is empty" << endl;
+    Diagnostics::onEmpty();
     throw 1;
   }
-  cout << "Tail: " << this->arr[this->tail - 1] << endl;
   return this->arr[this->tail - 1];
 }
 
+//**********************************
+// Lock-free variants for handing items between threads.
+// Both round the capacity up to a power of two so wraparound is a mask instead of a branch,
+// and keep their indices counting up forever so full and empty never need a size field.
+// push_back and pop_front return false instead of printing when the queue is full or empty.
+//**********************************
+const std::size_t cacheLineSize = 64;
+
+inline std::size_t roundUpToPowerOfTwo(std::size_t n) {
+  std::size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Single producer, single consumer.  Only the producer thread may call push_back and back,
+// and only the consumer thread may call pop_front and front.
+template <typename T>
+class SpscQueueForCS2420 {
+public:
+  SpscQueueForCS2420(const unsigned int capacity);
+  ~SpscQueueForCS2420();
+  SpscQueueForCS2420(const SpscQueueForCS2420<T>&) = delete;
+  SpscQueueForCS2420<T>& operator=(const SpscQueueForCS2420<T>&) = delete;
+  unsigned int numItems() const;
+  unsigned int getCapacity() const;
+  bool push_back(const T&);
+  bool push_back(T&&);
+  bool pop_front();
+  bool pop_front(T&);
+  T front();
+  T back();
+
+private:
+  template <typename U>
+  bool emplace_back(U&& item);
+
+  std::size_t capacity{ 0 };
+  std::size_t mask{ 0 };
+  T* arr{ nullptr };
+
+  // The consumer owns head and the producer owns tail.  Each side also keeps a
+  // stale copy of the other's index so it only touches the shared line when it looks full or empty.
+  alignas(cacheLineSize) std::atomic<std::size_t> head{ 0 };
+  std::size_t cachedTail{ 0 };
+  alignas(cacheLineSize) std::atomic<std::size_t> tail{ 0 };
+  std::size_t cachedHead{ 0 };
+};
+
+template <typename T>
+SpscQueueForCS2420<T>::SpscQueueForCS2420(const unsigned int capacity) {
+  this->capacity = roundUpToPowerOfTwo(capacity);
+  this->mask = this->capacity - 1;
+  this->arr = static_cast<T*>(::operator new(this->capacity * sizeof(T)));
+}
+
+template <typename T>
+SpscQueueForCS2420<T>::~SpscQueueForCS2420() {
+  while (this->pop_front()) {
+  }
+  ::operator delete(this->arr);
+}
+
+template <typename T>
+unsigned int SpscQueueForCS2420<T>::numItems() const {
+  std::size_t h = this->head.load(std::memory_order_acquire);
+  std::size_t t = this->tail.load(std::memory_order_acquire);
+  return static_cast<unsigned int>(t - h);
+}
+
+template <typename T>
+unsigned int SpscQueueForCS2420<T>::getCapacity() const {
+  return static_cast<unsigned int>(this->capacity);
+}
+
+template <typename T>
+bool SpscQueueForCS2420<T>::push_back(const T& item) {
+  return this->emplace_back(item);
+}
+
+template <typename T>
+bool SpscQueueForCS2420<T>::push_back(T&& item) {
+  return this->emplace_back(std::move(item));
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueueForCS2420<T>::emplace_back(U&& item) {
+  std::size_t t = this->tail.load(std::memory_order_relaxed);
+  if (t - this->cachedHead == this->capacity) {
+    this->cachedHead = this->head.load(std::memory_order_acquire);
+    if (t - this->cachedHead == this->capacity) {
+      return false;
+    }
+  }
+  new (&this->arr[t & this->mask]) T(std::forward<U>(item));
+  this->tail.store(t + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool SpscQueueForCS2420<T>::pop_front() {
+  std::size_t h = this->head.load(std::memory_order_relaxed);
+  if (h == this->cachedTail) {
+    this->cachedTail = this->tail.load(std::memory_order_acquire);
+    if (h == this->cachedTail) {
+      return false;
+    }
+  }
+  this->arr[h & this->mask].~T();
+  this->head.store(h + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool SpscQueueForCS2420<T>::pop_front(T& item) {
+  std::size_t h = this->head.load(std::memory_order_relaxed);
+  if (h == this->cachedTail) {
+    this->cachedTail = this->tail.load(std::memory_order_acquire);
+    if (h == this->cachedTail) {
+      return false;
+    }
+  }
+  item = std::move(this->arr[h & this->mask]);
+  this->arr[h & this->mask].~T();
+  this->head.store(h + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+T SpscQueueForCS2420<T>::front() {
+  std::size_t h = this->head.load(std::memory_order_relaxed);
+  if (h == this->tail.load(std::memory_order_acquire)) {
+    throw 1;
+  }
+  return this->arr[h & this->mask];
+}
+
+template <typename T>
+T SpscQueueForCS2420<T>::back() {
+  std::size_t t = this->tail.load(std::memory_order_relaxed);
+  if (t == this->head.load(std::memory_order_acquire)) {
+    throw 1;
+  }
+  return this->arr[(t - 1) & this->mask];
+}
+
+// Bounded multiple producer, multiple consumer queue.  Every slot carries a sequence number
+// that says whose turn it is, so producers and consumers only contend on the index they claim.
+// front and back are only meaningful while no other thread is changing the queue.
+template <typename T>
+class MpmcQueueForCS2420 {
+public:
+  MpmcQueueForCS2420(const unsigned int capacity);
+  ~MpmcQueueForCS2420();
+  MpmcQueueForCS2420(const MpmcQueueForCS2420<T>&) = delete;
+  MpmcQueueForCS2420<T>& operator=(const MpmcQueueForCS2420<T>&) = delete;
+  unsigned int numItems() const;
+  unsigned int getCapacity() const;
+  bool push_back(const T&);
+  bool push_back(T&&);
+  bool pop_front();
+  bool pop_front(T&);
+  T front();
+  T back();
+
+private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+    T* item() { return reinterpret_cast<T*>(this->storage); }
+  };
+
+  template <typename U>
+  bool emplace_back(U&& item);
+  Slot* claimFront();
+
+  std::size_t capacity{ 0 };
+  std::size_t mask{ 0 };
+  Slot* slots{ nullptr };
+
+  alignas(cacheLineSize) std::atomic<std::size_t> head{ 0 };
+  alignas(cacheLineSize) std::atomic<std::size_t> tail{ 0 };
+};
+
+template <typename T>
+MpmcQueueForCS2420<T>::MpmcQueueForCS2420(const unsigned int capacity) {
+  // The sequence numbers can't tell full from empty with a single slot.
+  this->capacity = roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity);
+  this->mask = this->capacity - 1;
+  this->slots = new Slot[this->capacity];
+  for (std::size_t i = 0; i < this->capacity; i++) {
+    this->slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+MpmcQueueForCS2420<T>::~MpmcQueueForCS2420() {
+  while (this->pop_front()) {
+  }
+  delete[] this->slots;
+}
+
+template <typename T>
+unsigned int MpmcQueueForCS2420<T>::numItems() const {
+  std::size_t h = this->head.load(std::memory_order_acquire);
+  std::size_t t = this->tail.load(std::memory_order_acquire);
+  return t > h ? static_cast<unsigned int>(t - h) : 0;
+}
+
+template <typename T>
+unsigned int MpmcQueueForCS2420<T>::getCapacity() const {
+  return static_cast<unsigned int>(this->capacity);
+}
+
+template <typename T>
+bool MpmcQueueForCS2420<T>::push_back(const T& item) {
+  return this->emplace_back(item);
+}
+
+template <typename T>
+bool MpmcQueueForCS2420<T>::push_back(T&& item) {
+  return this->emplace_back(std::move(item));
+}
+
+template <typename T>
+template <typename U>
+bool MpmcQueueForCS2420<T>::emplace_back(U&& item) {
+  std::size_t pos = this->tail.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &this->slots[pos & this->mask];
+    std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - pos);
+    if (diff == 0) {
+      // The slot is free for this lap, try to claim it.
+      if (this->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The consumer from the previous lap hasn't emptied it yet, so the queue is full.
+      return false;
+    } else {
+      pos = this->tail.load(std::memory_order_relaxed);
+    }
+  }
+  new (slot->item()) T(std::forward<U>(item));
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+// Claims the slot at the head for this thread, or returns nullptr when the queue is empty.
+template <typename T>
+typename MpmcQueueForCS2420<T>::Slot* MpmcQueueForCS2420<T>::claimFront() {
+  std::size_t pos = this->head.load(std::memory_order_relaxed);
+  while (true) {
+    Slot* slot = &this->slots[pos & this->mask];
+    std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+    if (diff == 0) {
+      if (this->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (diff < 0) {
+      return nullptr;
+    } else {
+      pos = this->head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool MpmcQueueForCS2420<T>::pop_front() {
+  Slot* slot = this->claimFront();
+  if (!slot) {
+    return false;
+  }
+  std::size_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  slot->item()->~T();
+  // Hand the slot to the producer one lap ahead.
+  slot->sequence.store(sequence + this->mask, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool MpmcQueueForCS2420<T>::pop_front(T& item) {
+  Slot* slot = this->claimFront();
+  if (!slot) {
+    return false;
+  }
+  std::size_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  item = std::move(*slot->item());
+  slot->item()->~T();
+  slot->sequence.store(sequence + this->mask, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+T MpmcQueueForCS2420<T>::front() {
+  std::size_t h = this->head.load(std::memory_order_acquire);
+  if (h == this->tail.load(std::memory_order_acquire)) {
+    throw 1;
+  }
+  return *this->slots[h & this->mask].item();
+}
+
+template <typename T>
+T MpmcQueueForCS2420<T>::back() {
+  std::size_t t = this->tail.load(std::memory_order_acquire);
+  if (t == this->head.load(std::memory_order_acquire)) {
+    throw 1;
+  }
+  return *this->slots[(t - 1) & this->mask].item();
+}
+
 //**********************************
 // Write your code above here
 //**********************************
@@ -453,6 +1074,416 @@ void testQueueMove() {
   }
 }
 
+// Counts the diagnostics calls so the test can see the hook was used.
+struct CountingQueueDiagnostics {
+  static int fullCount;
+  static int emptyCount;
+  static void onFull() { fullCount++; }
+  static void onEmpty() { emptyCount++; }
+};
+int CountingQueueDiagnostics::fullCount = 0;
+int CountingQueueDiagnostics::emptyCount = 0;
+
+void testQueueStatus() {
+  string coin;
+  {
+    QueueForCS2420<string> sQueue(2);
+    checkTest("testQueueStatus #1", true, sQueue.try_pop(coin) == QueueStatus::EMPTY);
+    checkTest("testQueueStatus #2", true, sQueue.try_push("penny") == QueueStatus::OK);
+    string nickel = "nickel";
+    checkTest("testQueueStatus #3", true, sQueue.try_push(std::move(nickel)) == QueueStatus::OK);
+    checkTest("testQueueStatus #4", true, sQueue.try_push("dime") == QueueStatus::FULL);
+    checkTest("testQueueStatus #5", 2, sQueue.numItems());
+
+    checkTest("testQueueStatus #6", true, sQueue.try_pop(coin) == QueueStatus::OK);
+    checkTest("testQueueStatus #7", "penny", coin);
+    checkTest("testQueueStatus #8", true, sQueue.pop_front(coin));
+    checkTest("testQueueStatus #9", "nickel", coin);
+    checkTest("testQueueStatus #10", false, sQueue.pop_front(coin));
+    checkTest("testQueueStatus #11", 0, sQueue.numItems());
+
+    // Going around the ring again.
+    sQueue.push_back("quarter");
+    sQueue.try_push("half dollar");
+    checkTest("testQueueStatus #12", "quarter", sQueue.front());
+    checkTest("testQueueStatus #13", "half dollar", sQueue.back());
+  }
+  {
+    QueueForCS2420<int, CountingQueueDiagnostics> iQueue(1);
+    int item = 0;
+    iQueue.push_back(1);
+    iQueue.push_back(2);
+    iQueue.try_push(3);
+    checkTest("testQueueStatus #14", 1, CountingQueueDiagnostics::fullCount);
+    iQueue.pop_front();
+    iQueue.pop_front();
+    iQueue.pop_front(item);
+    iQueue.try_pop(item);
+    try {
+      iQueue.front();
+    } catch (int) {
+    }
+    checkTest("testQueueStatus #15", 3, CountingQueueDiagnostics::emptyCount);
+  }
+}
+
+void testQueueBatches() {
+  {
+    QueueForCS2420<int> iQueue(5);
+    int in[7] = { 1, 2, 3, 4, 5, 6, 7 };
+    int out[7] = {};
+    iQueue.push_back(0);
+    iQueue.pop_front();
+    iQueue.push_back(0);
+    iQueue.pop_front();
+
+    // Only five of these fit (the capacity), and they wrap around the end of the array.
+    checkTest("testQueueBatches #1", 5, iQueue.push_back_n(in, 7));
+    checkTest("testQueueBatches #2", 5, iQueue.numItems());
+    checkTest("testQueueBatches #3", 1, iQueue.front());
+    checkTest("testQueueBatches #4", 5, iQueue.back());
+
+    QueueSpan<const int> span = iQueue.peek_contiguous();
+    checkTest("testQueueBatches #5", 3, span.size);
+    checkTest("testQueueBatches #6", 1, span.data[0]);
+
+    checkTest("testQueueBatches #7", 4, iQueue.pop_front_n(out, 4));
+    checkTest("testQueueBatches #8", 4, out[3]);
+    checkTest("testQueueBatches #9", 1, iQueue.numItems());
+    checkTest("testQueueBatches #10", 5, iQueue.front());
+
+    checkTest("testQueueBatches #11", 3, iQueue.push_back_n(in + 4, 3));
+    checkTest("testQueueBatches #12", 7, iQueue.back());
+    checkTest("testQueueBatches #13", 2, iQueue.pop_front_n(2));
+    checkTest("testQueueBatches #14", 6, iQueue.front());
+    checkTest("testQueueBatches #15", 2, iQueue.pop_front_n(out, 7));
+    checkTest("testQueueBatches #16", 7, out[1]);
+    checkTest("testQueueBatches #17", 0, iQueue.peek_contiguous().size);
+  }
+  {
+    QueueForCS2420<string> sQueue(3);
+    string in[3] = { "penny", "nickel", "dime" };
+    string out[3];
+    sQueue.push_back("quarter");
+    sQueue.pop_front();
+    sQueue.push_back_n(in, 3);
+    sQueue.pop_front_n(out, 3);
+    checkTest("testQueueBatches #18", "penny nickel dime", out[0] + " " + out[1] + " " + out[2]);
+  }
+}
+
+// A 64 byte record, the size of the telemetry records pushed through the queue.
+struct TelemetryRecord {
+  long long timestamp;
+  int source;
+  int kind;
+  double values[6];
+};
+
+void benchmarkQueueBatches() {
+  const unsigned int capacity = 1024;
+  const unsigned int batch = 256;
+  const int rounds = 20000;
+  QueueForCS2420<TelemetryRecord> queue(capacity);
+  vector<TelemetryRecord> in(batch);
+  vector<TelemetryRecord> out(batch);
+  for (unsigned int i = 0; i < batch; i++) {
+    in[i].timestamp = i;
+  }
+  // Offset the ring so batches keep wrapping around.
+  queue.push_back_n(in.data(), 100);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (unsigned int i = 0; i < batch; i++) {
+      queue.try_push(in[i]);
+    }
+    for (unsigned int i = 0; i < batch; i++) {
+      queue.try_pop(out[i]);
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  double singleTime = diff.count() / 1000.0;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    queue.push_back_n(in.data(), batch);
+    queue.pop_front_n(out.data(), batch);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  double batchTime = diff.count() / 1000.0;
+
+  cout << "Moving " << rounds * batch << " 64 byte records through the queue took " << singleTime
+       << " milliseconds one at a time, " << batchTime << " milliseconds in batches of " << batch << "." << endl;
+}
+
+void testQueueGrowth() {
+  {
+    QueueGrowthPolicy policy;
+    policy.grow = true;
+    policy.highWaterMark = 12;
+    QueueForCS2420<string> sQueue(3, policy);
+    sQueue.push_back("penny");
+    sQueue.push_back("nickel");
+    sQueue.pop_front();
+    sQueue.push_back("dime");
+    sQueue.push_back("quarter");
+
+    // Full and wrapped around, so this one has to unwrap the ring.
+    sQueue.push_back("half dollar");
+    checkTest("testQueueGrowth #1", 6, sQueue.getCapacity());
+    checkTest("testQueueGrowth #2", 4, sQueue.numItems());
+    checkTest("testQueueGrowth #3", "nickel", sQueue.front());
+    checkTest("testQueueGrowth #4", "half dollar", sQueue.back());
+    // After unwrapping, everything is one contiguous run.
+    QueueSpan<const string> span = sQueue.peek_contiguous();
+    checkTest("testQueueGrowth #5", 4, span.size);
+    checkTest("testQueueGrowth #5b", "quarter", span.data[2]);
+    sQueue.pop_front_n(span.size);
+
+    // It stops growing at the high-water mark.
+    for (int i = 0; i < 20; i++) {
+      sQueue.push_back("silver dollar");
+    }
+    checkTest("testQueueGrowth #6", 12, sQueue.getCapacity());
+    checkTest("testQueueGrowth #7", 12, sQueue.numItems());
+    checkTest("testQueueGrowth #8", true, sQueue.try_push("million dollar bill") == QueueStatus::FULL);
+
+    QueueStats stats = sQueue.getStats();
+    checkTest("testQueueGrowth #9", 2, stats.growths);
+    checkTest("testQueueGrowth #10", 12, stats.peakCapacity);
+    checkTest("testQueueGrowth #11", 12, stats.peakItems);
+  }
+  {
+    QueueGrowthPolicy policy;
+    policy.grow = true;
+    policy.shrink = true;
+    QueueForCS2420<int> iQueue(4, policy);
+    int in[40];
+    for (int i = 0; i < 40; i++) {
+      in[i] = i;
+    }
+    checkTest("testQueueGrowth #12", 40, iQueue.push_back_n(in, 40));
+    checkTest("testQueueGrowth #13", 40, iQueue.getCapacity());
+    checkTest("testQueueGrowth #14", 30, iQueue.pop_front_n(30));
+    checkTest("testQueueGrowth #15", 20, iQueue.getCapacity());
+    checkTest("testQueueGrowth #16", 30, iQueue.front());
+    int item = 0;
+    while (iQueue.try_pop(item) == QueueStatus::OK) {
+    }
+    checkTest("testQueueGrowth #17", 39, item);
+    // Never below where it started.
+    checkTest("testQueueGrowth #18", 4, iQueue.getCapacity());
+    checkTest("testQueueGrowth #19", 40, iQueue.getStats().peakCapacity);
+  }
+}
+
+template <template <typename> class Queue>
+void testConcurrentQueue(const string& name) {
+  string caughtError;
+  {
+    Queue<int> iQueue(3);
+    checkTest(name + " #1", 4, iQueue.getCapacity());
+    iQueue.push_back(1);
+    iQueue.push_back(2);
+    iQueue.push_back(3);
+    iQueue.push_back(4);
+    checkTest(name + " #2", false, iQueue.push_back(5));
+    checkTest(name + " #3", 4, iQueue.numItems());
+    checkTest(name + " #4", 1, iQueue.front());
+    checkTest(name + " #5", 4, iQueue.back());
+
+    // Go around the ring a few times.
+    int item = 0;
+    for (int i = 5; i < 15; i++) {
+      iQueue.pop_front(item);
+      iQueue.push_back(i);
+    }
+    checkTest(name + " #6", 10, item);
+    checkTest(name + " #7", 11, iQueue.front());
+    checkTest(name + " #8", 14, iQueue.back());
+    while (iQueue.pop_front()) {
+    }
+    checkTest(name + " #9", 0, iQueue.numItems());
+    checkTest(name + " #10", false, iQueue.pop_front(item));
+    caughtError = "not caught";
+    try {
+      iQueue.front();
+    } catch (int) {
+      caughtError = "caught";
+    }
+    checkTest(name + " #11", "caught", caughtError);
+  }
+  {
+    // Leftover strings are destroyed with the queue.
+    Queue<string> sQueue(8);
+    sQueue.push_back("penny");
+    sQueue.push_back(string(100, 'n'));
+    string coin;
+    sQueue.pop_front(coin);
+    checkTest(name + " #12", "penny", coin);
+  }
+  {
+    // One producer thread and one consumer thread should see every item, in order.
+    Queue<int> iQueue(64);
+    const int total = 100000;
+    std::thread producer([&iQueue, total]() {
+      for (int i = 0; i < total;) {
+        if (iQueue.push_back(i)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    bool inOrder = true;
+    for (int expected = 0; expected < total;) {
+      int item;
+      if (iQueue.pop_front(item)) {
+        inOrder = inOrder && item == expected;
+        expected++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    producer.join();
+    checkTest(name + " #13", true, inOrder);
+  }
+}
+
+void testMpmcQueueManyThreads() {
+  // Several producers and several consumers at once: every value pushed should be popped exactly once.
+  const int producers = 4;
+  const int consumers = 4;
+  const int perProducer = 50000;
+  const int total = producers * perProducer;
+  MpmcQueueForCS2420<int> iQueue(64);
+  std::atomic<int> consumed{ 0 };
+  vector<vector<int>> popped(consumers);
+  vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&iQueue, p, perProducer]() {
+      for (int i = 0; i < perProducer;) {
+        if (iQueue.push_back(p * perProducer + i)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&iQueue, &consumed, &popped, c, total]() {
+      int item;
+      while (consumed.load(std::memory_order_relaxed) < total) {
+        if (iQueue.pop_front(item)) {
+          popped[c].push_back(item);
+          consumed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  vector<int> timesSeen(total, 0);
+  bool inRange = true;
+  for (const vector<int>& items : popped) {
+    for (int item : items) {
+      if (item < 0 || item >= total) {
+        inRange = false;
+      } else {
+        timesSeen[item]++;
+      }
+    }
+  }
+  bool exactlyOnce = true;
+  for (int times : timesSeen) {
+    exactlyOnce = exactlyOnce && times == 1;
+  }
+  checkTest("testMpmcQueueManyThreads #1", total, consumed.load());
+  checkTest("testMpmcQueueManyThreads #2", true, inRange);
+  checkTest("testMpmcQueueManyThreads #3", true, exactlyOnce);
+  checkTest("testMpmcQueueManyThreads #4", 0, iQueue.numItems());
+}
+
+// Runs pairs producer/consumer pairs that hand itemsPerProducer items each through the queue,
+// and returns the millions of items per second that made it across.
+template <typename Queue>
+double measureQueueThroughput(Queue& queue, const int pairs, const int itemsPerProducer) {
+  std::atomic<int> consumed{ 0 };
+  const int total = pairs * itemsPerProducer;
+  vector<std::thread> threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int p = 0; p < pairs; p++) {
+    threads.emplace_back([&queue, itemsPerProducer]() {
+      for (int i = 0; i < itemsPerProducer;) {
+        if (queue.push_back(i)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&queue, &consumed, total]() {
+      int item;
+      while (consumed.load(std::memory_order_relaxed) < total) {
+        if (queue.pop_front(item)) {
+          consumed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return total / diff.count();
+}
+
+// The way the queue is fed today, the original QueueForCS2420 behind one mutex.
+class LockedQueueForCS2420 {
+public:
+  LockedQueueForCS2420(const unsigned int capacity) : queue(capacity) {}
+  bool push_back(const int item) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->queue.try_push(item) == QueueStatus::OK;
+  }
+  bool pop_front(int& item) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->queue.try_pop(item) == QueueStatus::OK;
+  }
+
+private:
+  std::mutex mutex;
+  QueueForCS2420<int> queue;
+};
+
+void benchmarkConcurrentQueues() {
+  const unsigned int capacity = 1024;
+  const int items = 400000;
+  cout << "Benchmarking queue throughput, millions of items per second (" << std::thread::hardware_concurrency() << " hardware threads)." << endl;
+  {
+    SpscQueueForCS2420<int> spsc(capacity);
+    cout << "    spsc,  2 threads: " << measureQueueThroughput(spsc, 1, items) << endl;
+  }
+  for (int pairs = 1; pairs <= 8; pairs *= 2) {
+    MpmcQueueForCS2420<int> mpmc(capacity);
+    LockedQueueForCS2420 locked(capacity);
+    double mpmcRate = measureQueueThroughput(mpmc, pairs, items / pairs);
+    double lockedRate = measureQueueThroughput(locked, pairs, items / pairs);
+    cout << "    mpmc, " << (pairs < 5 ? " " : "") << pairs * 2 << " threads: " << mpmcRate
+         << "    mutex: " << lockedRate << endl;
+  }
+}
+
 int main() {
 
   {
@@ -460,6 +1491,18 @@ int main() {
     pressAnyKeyToContinue();
     testQueueMove();
     pressAnyKeyToContinue();
+    testQueueStatus();
+    pressAnyKeyToContinue();
+    testQueueBatches();
+    benchmarkQueueBatches();
+    pressAnyKeyToContinue();
+    testQueueGrowth();
+    pressAnyKeyToContinue();
+    testConcurrentQueue<SpscQueueForCS2420>("testSpscQueue");
+    testConcurrentQueue<MpmcQueueForCS2420>("testMpmcQueue");
+    testMpmcQueueManyThreads();
+    benchmarkConcurrentQueues();
+    pressAnyKeyToContinue();
   }
   cout << "Shutting down the program" << endl;
   return 0;
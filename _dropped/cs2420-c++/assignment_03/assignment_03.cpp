@@ -1,9 +1,21 @@
 // Assignment 3, Chase May, CS 2420, Spring 2020.
 // Copyright 2019, Bradley Peterson, Weber State University, All rights reserved.
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <cstddef>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <new>
 #include <set>
 #include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 using std::cerr;
 using std::cin;
@@ -12,6 +24,7 @@ using std::endl;
 using std::set;
 using std::string;
 using std::stringstream;
+using std::vector;
 
 // class DestructorTester {
 // public:
@@ -54,13 +67,176 @@ public:
 };
 
 //******************
-// The linked list base class
+// Node allocators.  A list gets its nodes from one of these, picked with its
+// second template parameter.  allocate() builds a node holding a copy of data,
+// and deallocate() destroys it and gives the memory back.
 //******************
+
+// Every node is its own trip through the global new and delete.
+template <typename T>
+class NewNodeAllocator {
+public:
+  Node<T>* allocate(const T& data) { return new Node<T>{ data, nullptr }; }
+  void deallocate(Node<T>* node) { delete node; }
+};
+
+// Carves nodes out of slabs and keeps freed ones on a free list for reuse.
+// The slabs are only released when the pool itself goes away.
+template <typename T>
+class PoolNodeAllocator {
+public:
+  PoolNodeAllocator() {}
+  ~PoolNodeAllocator();
+  PoolNodeAllocator(const PoolNodeAllocator<T>&) = delete;
+  PoolNodeAllocator<T>& operator=(const PoolNodeAllocator<T>&) = delete;
+  Node<T>* allocate(const T& data);
+  void deallocate(Node<T>* node);
+
+private:
+  // A free slot holds the link to the next free slot, a used one holds a node.
+  union Slot {
+    Slot* next;
+    alignas(Node<T>) unsigned char storage[sizeof(Node<T>)];
+  };
+  static const unsigned int slotsPerSlab = 256;
+  struct Slab {
+    Slab* next;
+    Slot slots[slotsPerSlab];
+  };
+
+  Slab* slabs{ nullptr };
+  Slot* freeSlots{ nullptr };
+};
+
 template <typename T>
+PoolNodeAllocator<T>::~PoolNodeAllocator() {
+  while (slabs) {
+    Slab* temp = slabs;
+    slabs = slabs->next;
+    delete temp;
+  }
+}
+
+template <typename T>
+Node<T>* PoolNodeAllocator<T>::allocate(const T& data) {
+  if (!freeSlots) {
+    Slab* slab = new Slab;
+    slab->next = slabs;
+    slabs = slab;
+    for (unsigned int i = 0; i < slotsPerSlab; i++) {
+      slab->slots[i].next = freeSlots;
+      freeSlots = &slab->slots[i];
+    }
+  }
+  Slot* slot = freeSlots;
+  freeSlots = slot->next;
+  return new (slot->storage) Node<T>{ data, nullptr };
+}
+
+template <typename T>
+void PoolNodeAllocator<T>::deallocate(Node<T>* node) {
+  node->~Node<T>();
+  Slot* slot = reinterpret_cast<Slot*>(node);
+  slot->next = freeSlots;
+  freeSlots = slot;
+}
+
+// One pool per node type, shared by every list that uses this allocator, so nodes freed
+// by one list get reused by the next.  Like the lists themselves, it is not thread safe.
+template <typename T>
+class SharedPoolNodeAllocator {
+public:
+  Node<T>* allocate(const T& data) { return pool().allocate(data); }
+  void deallocate(Node<T>* node) { pool().deallocate(node); }
+
+private:
+  static PoolNodeAllocator<T>& pool() {
+    static PoolNodeAllocator<T> shared;
+    return shared;
+  }
+};
+
+//******************
+// Helpers for writing list items as text without a stringstream.
+// They print items the same way `ostream << item` would, with numbers going
+// through std::to_chars so nothing is allocated for them.
+//******************
+const std::size_t numberTextSize = 32;
+
+template <typename T>
+std::size_t formatNumber(char* buffer, const T& value) {
+  std::to_chars_result result;
+  if constexpr (std::is_floating_point<T>::value) {
+    // An ostream's default is %g with 6 significant digits.
+    result = std::to_chars(buffer, buffer + numberTextSize, value, std::chars_format::general, 6);
+  } else {
+    result = std::to_chars(buffer, buffer + numberTextSize, value);
+  }
+  return result.ptr - buffer;
+}
+
+template <typename T>
+const bool printsAsCharacter = std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value;
+
+template <typename T>
+std::size_t itemTextLength(const T& item) {
+  if constexpr (std::is_same<T, bool>::value || printsAsCharacter<T>) {
+    return 1;
+  } else if constexpr (std::is_arithmetic<T>::value) {
+    char buffer[numberTextSize];
+    return formatNumber(buffer, item);
+  } else if constexpr (std::is_same<T, string>::value) {
+    return item.size();
+  } else {
+    stringstream ss;
+    ss << item;
+    return ss.str().size();
+  }
+}
+
+template <typename OutputIt, typename T>
+OutputIt writeItemText(OutputIt out, const T& item) {
+  if constexpr (std::is_same<T, bool>::value) {
+    *out++ = item ? '1' : '0';
+    return out;
+  } else if constexpr (printsAsCharacter<T>) {
+    *out++ = static_cast<char>(item);
+    return out;
+  } else if constexpr (std::is_arithmetic<T>::value) {
+    char buffer[numberTextSize];
+    return std::copy(buffer, buffer + formatNumber(buffer, item), out);
+  } else if constexpr (std::is_same<T, string>::value) {
+    return std::copy(item.begin(), item.end(), out);
+  } else {
+    stringstream ss;
+    ss << item;
+    string text = ss.str();
+    return std::copy(text.begin(), text.end(), out);
+  }
+}
+
+template <typename OutputIt>
+OutputIt writeText(OutputIt out, const char* text) {
+  while (*text) {
+    *out++ = *text++;
+  }
+  return out;
+}
+
+const char emptyListText[] = "The list is empty.";
+
+//******************
+// The linked list base class
+//******************
+template <typename T, typename NodeAllocator = NewNodeAllocator<T>>
 class LinkedListBase {
 public:
   ~LinkedListBase();
   string getStringFromList();
+  std::size_t getStringLength() const;
+  template <typename OutputIt>
+  OutputIt writeList(OutputIt out) const;
+  std::size_t writeList(char* buffer, const std::size_t bufferSize) const;
   T getFifthElement() const {
     cerr << "Error: You didn't override this base class method yet" << endl;
     T temp{};
@@ -76,88 +252,120 @@ public:
   void deleteLast();
 
 protected:
+  Node<T>* newNode(const T& data) { return allocator.allocate(data); }
+  void deleteNode(Node<T>* node) { allocator.deallocate(node); }
+
   Node<T>* first{ nullptr };
   Node<T>* last{ nullptr };
   int count{ 0 };
+  NodeAllocator allocator;
 };
 
-template <typename T>
-LinkedListBase<T>::~LinkedListBase() {
+template <typename T, typename NodeAllocator>
+LinkedListBase<T, NodeAllocator>::~LinkedListBase() {
   Node<T>* temp = first;
   while (temp) {
     first = first->link;
-    delete temp;
+    deleteNode(temp);
     temp = first;
   }
 }
-// This method helps return a string representation of all nodes in the linked list, do not modify.
-template <typename T>
-string LinkedListBase<T>::getStringFromList() {
-  stringstream ss;
+// This method helps return a string representation of all nodes in the linked list.
+// It sizes the string up front and fills it with writeList(), so it allocates once.
+template <typename T, typename NodeAllocator>
+string LinkedListBase<T, NodeAllocator>::getStringFromList() {
+  string result(this->getStringLength(), ' ');
+  this->writeList(&result[0]);
+  return result;
+}
+
+// The length of what getStringFromList() returns, worked out without building it.
+template <typename T, typename NodeAllocator>
+std::size_t LinkedListBase<T, NodeAllocator>::getStringLength() const {
   if (!this->first) {
-    ss << "The list is empty.";
-  } else {
+    return sizeof(emptyListText) - 1;
+  }
+  std::size_t length = 0;
+  for (Node<T>* currentNode = this->first; currentNode; currentNode = currentNode->link) {
+    length += itemTextLength(currentNode->data) + 1;
+  }
+  // One less space than there are items.
+  return length - 1;
+}
 
-    Node<T>* currentNode = this->first;
-    ss << currentNode->data;
+// Writes the same text as getStringFromList() through an output iterator, and returns the iterator.
+template <typename T, typename NodeAllocator>
+template <typename OutputIt>
+OutputIt LinkedListBase<T, NodeAllocator>::writeList(OutputIt out) const {
+  if (!this->first) {
+    return writeText(out, emptyListText);
+  }
+  Node<T>* currentNode = this->first;
+  out = writeItemText(out, currentNode->data);
+  currentNode = currentNode->link;
+  while (currentNode) {
+    *out++ = ' ';
+    out = writeItemText(out, currentNode->data);
     currentNode = currentNode->link;
+  }
+  return out;
+}
 
-    while (currentNode) {
-      ss << " " << currentNode->data;
-      currentNode = currentNode->link;
-    };
+// Writes the text into the caller's buffer, without a terminating null, and returns its length.
+// If the buffer is too small nothing is written, and the length says how much room is needed.
+template <typename T, typename NodeAllocator>
+std::size_t LinkedListBase<T, NodeAllocator>::writeList(char* buffer, const std::size_t bufferSize) const {
+  std::size_t length = this->getStringLength();
+  if (length <= bufferSize) {
+    this->writeList<char*>(buffer);
   }
-  return ss.str();
+  return length;
 }
 
-template <typename T>
-T LinkedListBase<T>::getLast() const {
+template <typename T, typename NodeAllocator>
+T LinkedListBase<T, NodeAllocator>::getLast() const {
   if (this->last) {
     return this->last->data;
   } else {
     throw 1;
   }
 }
-template <typename T>
-void LinkedListBase<T>::insertFirst(const T& data) {
+template <typename T, typename NodeAllocator>
+void LinkedListBase<T, NodeAllocator>::insertFirst(const T& data) {
 
   if (!first) {
     // Scenario: The list is empty
-    Node<T>* temp = new Node<T>();
-    temp->data = data;
+    Node<T>* temp = newNode(data);
     first = temp;
     last = temp;
     count++;
   } else {
     // Scenario: One or more nodes
-    Node<T>* temp = new Node<T>();
-    temp->data = data;
+    Node<T>* temp = newNode(data);
     temp->link = first;
     first = temp;
     count++;
   }
 }
 
-template <typename T>
-void LinkedListBase<T>::insertLast(const T& data) {
+template <typename T, typename NodeAllocator>
+void LinkedListBase<T, NodeAllocator>::insertLast(const T& data) {
   if (!first) {
     // Scenario: The list is empty
-    Node<T>* temp = new Node<T>();
-    temp->data = data;
+    Node<T>* temp = newNode(data);
     first = temp;
     last = temp;
     count++;
   } else {
-    Node<T>* temp = new Node<T>();
-    temp->data = data;
+    Node<T>* temp = newNode(data);
     last->link = temp;
     last = temp;
     count++;
   }
 }
 
-template <typename T>
-void LinkedListBase<T>::deleteFirst() {
+template <typename T, typename NodeAllocator>
+void LinkedListBase<T, NodeAllocator>::deleteFirst() {
 
   if (!first) {
     // Scenario: The list is empty
@@ -166,21 +374,21 @@ void LinkedListBase<T>::deleteFirst() {
   } else if (first == last) {
     // Scenario: One node list
     last = nullptr;
-    delete first;
+    deleteNode(first);
     first = nullptr;
     count--;
   } else {
     // Scenario: General, at least two or more nodes
     Node<T>* temp = nullptr;
     temp = first->link;
-    delete first;
+    deleteNode(first);
     first = temp;
     count--;
   }
 }
 
-template <typename T>
-void LinkedListBase<T>::deleteLast() {
+template <typename T, typename NodeAllocator>
+void LinkedListBase<T, NodeAllocator>::deleteLast() {
   if (!first) {
     // Scenario: The list is empty
     cout << "The list was already empty" << endl;
@@ -188,7 +396,7 @@ void LinkedListBase<T>::deleteLast() {
   } else if (first == last) {
     // Scenario: One node list
     last = nullptr;
-    delete first;
+    deleteNode(first);
     first = nullptr;
     count--;
   } else {
@@ -201,7 +409,7 @@ void LinkedListBase<T>::deleteLast() {
     }
 
     // temp is now at the second to last node
-    delete last;
+    deleteNode(last);
     last = temp;
     last->link = nullptr;
     count--;
@@ -212,8 +420,8 @@ void LinkedListBase<T>::deleteLast() {
 // Write your code below here
 //**********************************
 
-template <typename T>
-class SinglyLinkedList : public LinkedListBase<T> {
+template <typename T, typename NodeAllocator = NewNodeAllocator<T>>
+class SinglyLinkedList : public LinkedListBase<T, NodeAllocator> {
 public:
   T getFifthElement() const;
   void insertNewFifthElement(const T&);
@@ -221,8 +429,8 @@ public:
   void swapFourthAndFifthElement();
 };
 
-template <typename T>
-T SinglyLinkedList<T>::getFifthElement() const {
+template <typename T, typename NodeAllocator>
+T SinglyLinkedList<T, NodeAllocator>::getFifthElement() const {
   Node<T>* currentNode = this->first;
 
   int count = 1;
@@ -241,8 +449,8 @@ T SinglyLinkedList<T>::getFifthElement() const {
   }
 }
 
-template <typename T>
-void SinglyLinkedList<T>::insertNewFifthElement(const T& value) {
+template <typename T, typename NodeAllocator>
+void SinglyLinkedList<T, NodeAllocator>::insertNewFifthElement(const T& value) {
   Node<T>* currentNode = this->first;
   int count = 1;
 
@@ -259,8 +467,7 @@ void SinglyLinkedList<T>::insertNewFifthElement(const T& value) {
 
   Node<T>* nextNode = currentNode->link;
 
-  Node<T>* newNode = new Node<T>;
-  newNode->data = value;
+  Node<T>* newNode = this->newNode(value);
   newNode->link = nextNode;
 
   currentNode->link = newNode;
@@ -271,8 +478,8 @@ void SinglyLinkedList<T>::insertNewFifthElement(const T& value) {
   // cout << this->getStringFromList() << endl;
 }
 
-template <typename T>
-void SinglyLinkedList<T>::deleteFifthElement() {
+template <typename T, typename NodeAllocator>
+void SinglyLinkedList<T, NodeAllocator>::deleteFifthElement() {
   Node<T>* currentNode = this->first;
   int count = 1;
 
@@ -294,11 +501,11 @@ void SinglyLinkedList<T>::deleteFifthElement() {
   if (currentNode->link == nullptr) {
     this->last = currentNode;
   }
-  delete fifthNode;
+  this->deleteNode(fifthNode);
 }
 
-template <typename T>
-void SinglyLinkedList<T>::swapFourthAndFifthElement() {
+template <typename T, typename NodeAllocator>
+void SinglyLinkedList<T, NodeAllocator>::swapFourthAndFifthElement() {
   Node<T>* currentNode = this->first;
   int count = 1;
 
@@ -325,6 +532,341 @@ void SinglyLinkedList<T>::swapFourthAndFifthElement() {
   }
 }
 
+//******************
+// An unrolled list, with the same interface as SinglyLinkedList.
+// Each node holds up to K items side by side plus a link in each direction,
+// so there are 2 / K pointers per item instead of 1, and deleteLast is O(1)
+// because the last node knows the one before it.  Positional operations skip
+// a whole node at a time.
+//******************
+template <typename T, unsigned int K = 16>
+class UnrolledLinkedList {
+public:
+  UnrolledLinkedList() {}
+  ~UnrolledLinkedList();
+  UnrolledLinkedList(const UnrolledLinkedList<T, K>&) = delete;
+  UnrolledLinkedList<T, K>& operator=(const UnrolledLinkedList<T, K>&) = delete;
+  string getStringFromList();
+  T getFifthElement() const;
+  void insertNewFifthElement(const T&);
+  void deleteFifthElement();
+  void swapFourthAndFifthElement();
+  T getLast() const;
+  void insertFirst(const T& data);
+  void insertLast(const T& data);
+  void deleteFirst();
+  void deleteLast();
+  unsigned int size() const { return count; }
+  unsigned int blockCount() const;
+
+private:
+  struct Block {
+    Block* backward{ nullptr };
+    Block* forward{ nullptr };
+    unsigned int used{ 0 };
+    alignas(T) unsigned char storage[K * sizeof(T)];
+    T* items() { return reinterpret_cast<T*>(storage); }
+  };
+
+  Block* find(unsigned int& index) const;
+  Block* insertBlockAfter(Block* block);
+  void unlinkBlock(Block* block);
+  void rebalance(Block* block);
+  void insertAt(unsigned int index, const T& data);
+  void removeAt(unsigned int index);
+
+  Block* first{ nullptr };
+  Block* last{ nullptr };
+  unsigned int count{ 0 };
+};
+
+template <typename T, unsigned int K>
+UnrolledLinkedList<T, K>::~UnrolledLinkedList() {
+  while (first) {
+    Block* temp = first;
+    first = first->forward;
+    for (unsigned int i = 0; i < temp->used; i++) {
+      temp->items()[i].~T();
+    }
+    delete temp;
+  }
+}
+
+// Finds the block holding the item at index, and turns index into the position inside that block.
+template <typename T, unsigned int K>
+typename UnrolledLinkedList<T, K>::Block* UnrolledLinkedList<T, K>::find(unsigned int& index) const {
+  Block* block = first;
+  while (block && index >= block->used) {
+    index -= block->used;
+    block = block->forward;
+  }
+  return block;
+}
+
+// Links a new empty block in after block, or at the front when block is nullptr.
+template <typename T, unsigned int K>
+typename UnrolledLinkedList<T, K>::Block* UnrolledLinkedList<T, K>::insertBlockAfter(Block* block) {
+  Block* temp = new Block;
+  temp->backward = block;
+  temp->forward = block ? block->forward : first;
+  if (temp->forward) {
+    temp->forward->backward = temp;
+  } else {
+    last = temp;
+  }
+  if (block) {
+    block->forward = temp;
+  } else {
+    first = temp;
+  }
+  return temp;
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::unlinkBlock(Block* block) {
+  if (block->backward) {
+    block->backward->forward = block->forward;
+  } else {
+    first = block->forward;
+  }
+  if (block->forward) {
+    block->forward->backward = block->backward;
+  } else {
+    last = block->backward;
+  }
+  delete block;
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::insertAt(unsigned int index, const T& data) {
+  Block* block;
+  if (index == count) {
+    // Appending goes in the last block, no need to search.
+    block = last;
+    index = block ? block->used : 0;
+  } else {
+    block = find(index);
+  }
+  if (!block) {
+    block = insertBlockAfter(nullptr);
+  } else if (block->used == K && index == K) {
+    // Growing off the end of a full block starts a fresh one rather than splitting.
+    block = insertBlockAfter(block);
+    index = 0;
+  } else if (block->used == K && index == 0) {
+    block = insertBlockAfter(block->backward);
+  } else if (block->used == K) {
+    // Split the full block, moving its back half into a new block after it.
+    Block* half = insertBlockAfter(block);
+    unsigned int keep = K / 2;
+    for (unsigned int i = keep; i < K; i++) {
+      new (&half->items()[i - keep]) T(std::move(block->items()[i]));
+      block->items()[i].~T();
+    }
+    half->used = K - keep;
+    block->used = keep;
+    if (index > keep) {
+      index -= keep;
+      block = half;
+    }
+  }
+  T* items = block->items();
+  if (index == block->used) {
+    new (&items[index]) T(data);
+  } else {
+    // Shift the tail of the block up one to open the slot.
+    new (&items[block->used]) T(std::move(items[block->used - 1]));
+    for (unsigned int i = block->used - 1; i > index; i--) {
+      items[i] = std::move(items[i - 1]);
+    }
+    items[index] = data;
+  }
+  block->used++;
+  count++;
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::removeAt(unsigned int index) {
+  Block* block = find(index);
+  T* items = block->items();
+  for (unsigned int i = index; i + 1 < block->used; i++) {
+    items[i] = std::move(items[i + 1]);
+  }
+  block->used--;
+  items[block->used].~T();
+  count--;
+  rebalance(block);
+}
+
+// Called after a removal.  A block left under K / 2 merges with a neighbour when both fit in one
+// block, and otherwise evens out with it, so churn can't leave a chain of nearly empty blocks
+// each paying for two links and K slots.
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::rebalance(Block* block) {
+  if (block->used == 0) {
+    unlinkBlock(block);
+    return;
+  }
+  if (block->used >= K / 2 || (!block->forward && !block->backward)) {
+    return;
+  }
+  Block* earlier = block->forward ? block : block->backward;
+  Block* later = earlier->forward;
+  T* front = earlier->items();
+  T* back = later->items();
+  if (earlier->used + later->used <= K) {
+    for (unsigned int i = 0; i < later->used; i++) {
+      new (&front[earlier->used + i]) T(std::move(back[i]));
+      back[i].~T();
+    }
+    earlier->used += later->used;
+    later->used = 0;
+    unlinkBlock(later);
+  } else if (earlier->used < later->used) {
+    // Move the front of the later block onto the end of the earlier one.
+    unsigned int moved = (later->used - earlier->used) / 2;
+    for (unsigned int i = 0; i < moved; i++) {
+      new (&front[earlier->used + i]) T(std::move(back[i]));
+    }
+    for (unsigned int i = moved; i < later->used; i++) {
+      back[i - moved] = std::move(back[i]);
+    }
+    for (unsigned int i = later->used - moved; i < later->used; i++) {
+      back[i].~T();
+    }
+    earlier->used += moved;
+    later->used -= moved;
+  } else {
+    // Move the end of the earlier block onto the front of the later one.
+    unsigned int moved = (earlier->used - later->used) / 2;
+    for (unsigned int i = later->used + moved; i-- > moved;) {
+      if (i >= later->used) {
+        new (&back[i]) T(std::move(back[i - moved]));
+      } else {
+        back[i] = std::move(back[i - moved]);
+      }
+    }
+    for (unsigned int i = 0; i < moved; i++) {
+      T& source = front[earlier->used - moved + i];
+      if (i < later->used) {
+        back[i] = std::move(source);
+      } else {
+        new (&back[i]) T(std::move(source));
+      }
+      source.~T();
+    }
+    earlier->used -= moved;
+    later->used += moved;
+  }
+}
+
+template <typename T, unsigned int K>
+unsigned int UnrolledLinkedList<T, K>::blockCount() const {
+  unsigned int blocks = 0;
+  for (Block* block = first; block; block = block->forward) {
+    blocks++;
+  }
+  return blocks;
+}
+
+// Same output as LinkedListBase::getStringFromList().
+template <typename T, unsigned int K>
+string UnrolledLinkedList<T, K>::getStringFromList() {
+  stringstream ss;
+  if (!first) {
+    ss << "The list is empty.";
+  } else {
+    bool firstItem = true;
+    for (Block* block = first; block; block = block->forward) {
+      for (unsigned int i = 0; i < block->used; i++) {
+        if (!firstItem) {
+          ss << " ";
+        }
+        ss << block->items()[i];
+        firstItem = false;
+      }
+    }
+  }
+  return ss.str();
+}
+
+template <typename T, unsigned int K>
+T UnrolledLinkedList<T, K>::getFifthElement() const {
+  if (count < 5) {
+    throw 1;
+  }
+  unsigned int index = 4;
+  Block* block = find(index);
+  return block->items()[index];
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::insertNewFifthElement(const T& data) {
+  if (count >= 4) {
+    insertAt(4, data);
+  }
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::deleteFifthElement() {
+  if (count >= 5) {
+    removeAt(4);
+  }
+}
+
+// Items live inline in the blocks, so this swaps the values rather than relinking nodes.
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::swapFourthAndFifthElement() {
+  if (count < 5) {
+    return;
+  }
+  unsigned int fourth = 3;
+  Block* fourthBlock = find(fourth);
+  unsigned int fifth = 4;
+  Block* fifthBlock = find(fifth);
+  std::swap(fourthBlock->items()[fourth], fifthBlock->items()[fifth]);
+}
+
+template <typename T, unsigned int K>
+T UnrolledLinkedList<T, K>::getLast() const {
+  if (last) {
+    return last->items()[last->used - 1];
+  } else {
+    throw 1;
+  }
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::insertFirst(const T& data) {
+  insertAt(0, data);
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::insertLast(const T& data) {
+  insertAt(count, data);
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::deleteFirst() {
+  if (!first) {
+    cout << "The list was already empty" << endl;
+    return;
+  }
+  removeAt(0);
+}
+
+template <typename T, unsigned int K>
+void UnrolledLinkedList<T, K>::deleteLast() {
+  if (!last) {
+    cout << "The list was already empty" << endl;
+    return;
+  }
+  last->used--;
+  last->items()[last->used].~T();
+  count--;
+  rebalance(last);
+}
+
 //**********************************
 // Write your code above here
 //**********************************
@@ -645,6 +1187,327 @@ void testSwapFourthAndFifthElement() {
   // }
 }
 
+template <template <typename> class NodeAllocator>
+void testNodeAllocator(const string& name) {
+  SinglyLinkedList<int, NodeAllocator<int>>* si = new SinglyLinkedList<int, NodeAllocator<int>>;
+  for (int i = 10; i < 20; i++) {
+    si->insertLast(i);
+  }
+  si->insertFirst(9);
+  si->deleteLast();
+  checkTest(name + " #1", "9 10 11 12 13 14 15 16 17 18", si->getStringFromList());
+  si->insertNewFifthElement(97);
+  si->deleteFifthElement();
+  si->deleteFifthElement();
+  checkTest(name + " #2", "9 10 11 12 14 15 16 17 18", si->getStringFromList());
+
+  // Freed nodes should get handed out again.
+  for (int i = 0; i < 1000; i++) {
+    si->deleteFirst();
+    si->insertLast(i);
+  }
+  checkTest(name + " #3", "991 992 993 994 995 996 997 998 999", si->getStringFromList());
+  checkTest(name + " #4", 995, si->getFifthElement());
+  delete si;
+
+  SinglyLinkedList<string, NodeAllocator<string>> ss;
+  ss.insertLast("Multi Pass");
+  ss.insertLast("Lelu Dallas");
+  ss.insertFirst("Korben Dallas");
+  ss.deleteFirst();
+  checkTest(name + " #5", "Multi Pass Lelu Dallas", ss.getStringFromList());
+}
+
+// The resident set size of this process, or 0 where /proc isn't available.
+long currentRssKilobytes() {
+  std::ifstream status("/proc/self/status");
+  string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      return std::stol(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+template <template <typename> class NodeAllocator>
+void benchmarkNodeAllocator(const string& name) {
+  const int listSize = 1000000;
+  const int churnRounds = 20;
+#ifdef __GLIBC__
+  // Hand memory freed by the previous run back to the system, so it isn't counted for free here.
+  malloc_trim(0);
+#endif
+  long rssBefore = currentRssKilobytes();
+  SinglyLinkedList<int, NodeAllocator<int>>* si = new SinglyLinkedList<int, NodeAllocator<int>>;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < churnRounds; round++) {
+    for (int i = 0; i < listSize / churnRounds; i++) {
+      si->insertLast(i);
+    }
+    for (int i = 0; i < listSize / churnRounds; i++) {
+      si->deleteFirst();
+    }
+  }
+  for (int i = 0; i < listSize; i++) {
+    si->insertFirst(i);
+  }
+  long rssFull = currentRssKilobytes();
+  for (int i = 0; i < listSize; i++) {
+    si->deleteFirst();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  delete si;
+
+  cout << "    " << name << ": " << (diff.count() / 1000.0) << " milliseconds for "
+       << (listSize * 4) << " inserts and deletes, RSS grew " << (rssFull - rssBefore) << " KB holding "
+       << listSize << " nodes." << endl;
+}
+
+void benchmarkNodeAllocators() {
+  cout << "Benchmarking node allocation." << endl;
+  benchmarkNodeAllocator<NewNodeAllocator>("global new and delete");
+  benchmarkNodeAllocator<PoolNodeAllocator>("per-list pool");
+  benchmarkNodeAllocator<SharedPoolNodeAllocator>("shared pool");
+}
+
+void testUnrolledLinkedList() {
+  UnrolledLinkedList<int, 4>* ui = new UnrolledLinkedList<int, 4>;
+  for (int i = 10; i < 20; i++) {
+    ui->insertLast(i);
+  }
+  checkTest("testUnrolledLinkedList #1", "10 11 12 13 14 15 16 17 18 19", ui->getStringFromList());
+  checkTest("testUnrolledLinkedList #2", 14, ui->getFifthElement());
+  ui->insertNewFifthElement(97);
+  checkTest("testUnrolledLinkedList #3", "10 11 12 13 97 14 15 16 17 18 19", ui->getStringFromList());
+  ui->deleteFifthElement();
+  ui->deleteFifthElement();
+  checkTest("testUnrolledLinkedList #4", "10 11 12 13 15 16 17 18 19", ui->getStringFromList());
+  ui->swapFourthAndFifthElement();
+  checkTest("testUnrolledLinkedList #5", "10 11 12 15 13 16 17 18 19", ui->getStringFromList());
+  ui->insertFirst(9);
+  ui->insertFirst(8);
+  checkTest("testUnrolledLinkedList #6", "8 9 10 11 12 15 13 16 17 18 19", ui->getStringFromList());
+
+  for (int i = 0; i < 6; i++) {
+    ui->deleteLast();
+  }
+  checkTest("testUnrolledLinkedList #7", "8 9 10 11 12", ui->getStringFromList());
+  checkTest("testUnrolledLinkedList #8", 12, ui->getLast());
+  ui->deleteFifthElement();
+  checkTest("testUnrolledLinkedList #9", 11, ui->getLast());
+  ui->insertNewFifthElement(20);
+  checkTest("testUnrolledLinkedList #10", 20, ui->getLast());
+  while (ui->size() > 3) {
+    ui->deleteFirst();
+  }
+  checkTest("testUnrolledLinkedList #11", "10 11 20", ui->getStringFromList());
+  string caughtError = "";
+  try {
+    ui->getFifthElement();
+  } catch (int) {
+    caughtError = "caught";
+  }
+  checkTest("testUnrolledLinkedList #12", "caught", caughtError);
+  ui->deleteFifthElement();
+  ui->insertNewFifthElement(1000);
+  checkTest("testUnrolledLinkedList #13", "10 11 20", ui->getStringFromList());
+  ui->deleteLast();
+  ui->deleteLast();
+  ui->deleteLast();
+  checkTest("testUnrolledLinkedList #14", "The list is empty.", ui->getStringFromList());
+  delete ui;
+
+  UnrolledLinkedList<string> us;
+  us.insertLast("Multi Pass");
+  us.insertLast("Lelu Dallas");
+  us.insertLast("BIG BADA BOOM");
+  us.insertLast("Bruce Willis");
+  us.insertLast("Fried Chicken");
+  checkTest("testUnrolledLinkedList #15", "Fried Chicken", us.getFifthElement());
+  us.deleteLast();
+  checkTest("testUnrolledLinkedList #16", "Bruce Willis", us.getLast());
+
+  // Deleting in the middle and inserting at the front leaves blocks thinned out behind the fifth
+  // position; a block dropping under half full should merge with or borrow from a neighbour, so
+  // the blocks stay at least half full on average.  A vector doing the same operations says what
+  // the list should hold.
+  UnrolledLinkedList<int, 8> churn;
+  vector<int> reference;
+  for (int i = 0; i < 400; i++) {
+    if (churn.size() < 4) {
+      churn.insertLast(i);
+      reference.push_back(i);
+    } else {
+      churn.insertNewFifthElement(i);
+      reference.insert(reference.begin() + 4, i);
+    }
+  }
+  for (int round = 0; round < 100; round++) {
+    for (int i = 0; i < 7; i++) {
+      churn.deleteFifthElement();
+      reference.erase(reference.begin() + 4);
+    }
+    for (int i = 0; i < 8; i++) {
+      churn.insertFirst(round);
+      reference.insert(reference.begin(), round);
+    }
+  }
+  string expected;
+  for (int item : reference) {
+    expected += (expected.empty() ? "" : " ") + std::to_string(item);
+  }
+  checkTest("testUnrolledLinkedList #17", expected, churn.getStringFromList());
+  checkTest("testUnrolledLinkedList #18", true, churn.blockCount() <= churn.size() / 4 + 1);
+  while (churn.size() > 2) {
+    churn.deleteLast();
+  }
+  checkTest("testUnrolledLinkedList #19", 1, churn.blockCount());
+  checkTest("testUnrolledLinkedList #20", expected.substr(0, expected.find(' ', expected.find(' ') + 1)), churn.getStringFromList());
+}
+
+template <typename List>
+double timeTailTrimming(const int listSize, const int rounds) {
+  List list;
+  for (int i = 0; i < listSize; i++) {
+    list.insertLast(i);
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    list.insertFirst(i);
+    list.deleteLast();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return diff.count() / 1000.0;
+}
+
+template <typename List>
+double timeFifthElementOperations(const int listSize, const int rounds) {
+  List list;
+  for (int i = 0; i < listSize; i++) {
+    list.insertLast(i);
+  }
+  long long sum = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    list.insertNewFifthElement(i);
+    sum += list.getFifthElement();
+    list.deleteFifthElement();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  // Use the sum so the reads can't be optimized away.
+  if (sum == -1) {
+    cout << sum;
+  }
+  return diff.count() / 1000.0;
+}
+
+void benchmarkUnrolledLinkedList() {
+  cout << "Benchmarking SinglyLinkedList against UnrolledLinkedList." << endl;
+  cout << "    10,000 insertFirst + deleteLast pairs on a 10,000 item list: "
+       << timeTailTrimming<SinglyLinkedList<int>>(10000, 10000) << " milliseconds singly linked, "
+       << timeTailTrimming<UnrolledLinkedList<int>>(10000, 10000) << " milliseconds unrolled." << endl;
+  cout << "    1,000,000 rounds of insertNewFifthElement + getFifthElement + deleteFifthElement: "
+       << timeFifthElementOperations<SinglyLinkedList<int>>(100, 1000000) << " milliseconds singly linked, "
+       << timeFifthElementOperations<UnrolledLinkedList<int>>(100, 1000000) << " milliseconds unrolled." << endl;
+}
+
+void testWriteList() {
+  SinglyLinkedList<int> si;
+  checkTest("testWriteList #1", "The list is empty.", si.getStringFromList());
+  checkTest("testWriteList #2", 18, si.getStringLength());
+  for (int i = -2; i < 12; i += 3) {
+    si.insertLast(i);
+  }
+  checkTest("testWriteList #3", "-2 1 4 7 10", si.getStringFromList());
+  checkTest("testWriteList #4", 11, si.getStringLength());
+
+  char buffer[16] = {};
+  checkTest("testWriteList #5", 11, si.writeList(buffer, 10));
+  checkTest("testWriteList #6", "", string(buffer));
+  checkTest("testWriteList #7", 11, si.writeList(buffer, sizeof(buffer)));
+  checkTest("testWriteList #8", "-2 1 4 7 10", string(buffer, 11));
+
+  string appended = "list: ";
+  si.writeList(std::back_inserter(appended));
+  checkTest("testWriteList #9", "list: -2 1 4 7 10", appended);
+
+  // These should match what a stringstream prints.
+  SinglyLinkedList<double> sd;
+  sd.insertLast(3.14159265);
+  sd.insertLast(0.5);
+  sd.insertLast(1e20);
+  sd.insertLast(100);
+  checkTest("testWriteList #10", "3.14159 0.5 1e+20 100", sd.getStringFromList());
+  SinglyLinkedList<char> sc;
+  sc.insertLast('a');
+  sc.insertLast('z');
+  checkTest("testWriteList #11", "a z", sc.getStringFromList());
+  SinglyLinkedList<string> ss;
+  ss.insertLast("Multi Pass");
+  ss.insertLast("Lelu Dallas");
+  checkTest("testWriteList #12", "Multi Pass Lelu Dallas", ss.getStringFromList());
+}
+
+// Adds back the original stringstream version of getStringFromList() to compare against.
+class StringstreamSinglyLinkedList : public SinglyLinkedList<int> {
+public:
+  string getStringFromListWithStringstream() {
+    stringstream ss;
+    if (!this->first) {
+      ss << "The list is empty.";
+    } else {
+      Node<int>* currentNode = this->first;
+      ss << currentNode->data;
+      currentNode = currentNode->link;
+      while (currentNode) {
+        ss << " " << currentNode->data;
+        currentNode = currentNode->link;
+      };
+    }
+    return ss.str();
+  }
+};
+
+void benchmarkWriteList() {
+  const int rounds = 10000;
+  StringstreamSinglyLinkedList si;
+  for (int i = 0; i < 100; i++) {
+    si.insertLast(i * 997);
+  }
+  std::size_t total = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    total += si.getStringFromListWithStringstream().size();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> streamTime = end - start;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    total += si.getStringFromList().size();
+  }
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> stringTime = end - start;
+
+  char buffer[1024];
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    total += si.writeList(buffer, sizeof(buffer));
+  }
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> bufferTime = end - start;
+
+  cout << "Turning a 100 item list into text 10,000 times took " << (streamTime.count() / 1000.0)
+       << " milliseconds with a stringstream, " << (stringTime.count() / 1000.0) << " with getStringFromList, "
+       << (bufferTime.count() / 1000.0) << " with writeList into a buffer (" << total << " characters)." << endl;
+}
+
 void pressAnyKeyToContinue() {
   cout << "Press enter to continue...";
   cin.get();
@@ -657,5 +1520,15 @@ int main() {
   testDeleteFifthElement();
   testSwapFourthAndFifthElement();
   pressAnyKeyToContinue();
+  testNodeAllocator<PoolNodeAllocator>("testPoolNodeAllocator");
+  testNodeAllocator<SharedPoolNodeAllocator>("testSharedPoolNodeAllocator");
+  benchmarkNodeAllocators();
+  pressAnyKeyToContinue();
+  testUnrolledLinkedList();
+  benchmarkUnrolledLinkedList();
+  pressAnyKeyToContinue();
+  testWriteList();
+  benchmarkWriteList();
+  pressAnyKeyToContinue();
   return 0;
 }
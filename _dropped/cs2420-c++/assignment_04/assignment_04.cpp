@@ -1,8 +1,19 @@
 // Copyright 2020, Bradley Peterson, Weber State University, All rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using std::cerr;
 using std::cin;
@@ -17,42 +28,297 @@ using std::stringstream;
 // For this to work, a class needs to inherit off of this one.
 // Then this does the rest of the work, since it
 // overloads new, new[], delete, and delete[].
+//
+// Each allocation carries a small header holding its size.  The counts are
+// kept in shards, each thread claiming one of its own while there are free
+// ones, so threads don't fight over one counter, and are added up whenever
+// they are read.  A live count per power-of-two size class is also
+// kept while the histogram is turned on.
+//
+// The trade-off: counting an allocation no longer touches anything shared,
+// but reading a count adds up every shard instead of loading one number, and
+// the peak is only exact to within peakGranularity bytes per shard, since
+// shards publish their bytes in batches.  The live totals are still exact.
 //************************************************************************
+
+// What the tracked allocations looked like at one moment, see ManageMemory::snapshot().
+struct MemorySnapshot {
+  long long liveBytes{ 0 };
+  long long liveAllocations{ 0 };
+  long long allocations{ 0 };
+  std::size_t peakBytes{ 0 };
+  // How many allocations there have been of each size, most allocated first.
+  std::vector<std::pair<std::size_t, long long>> allocationSizes;
+
+  // What changed since an earlier snapshot.  The peak is kept as is, it can't be subtracted.
+  MemorySnapshot diff(const MemorySnapshot& earlier) const;
+};
+
 class ManageMemory {
 public:
-  static std::size_t getTotalSize() {
-    std::size_t total = 0;
-    std::map<void*, std::size_t>::iterator iter;
-    for (iter = mapOfAllocations.begin(); iter != mapOfAllocations.end(); ++iter) {
-      total += iter->second;
+  // Size class n holds allocations of more than 2^(n-1) and at most 2^n bytes.
+  static const unsigned int sizeClassCount = 65;
+  // The last shard is shared by any threads that found the others all claimed.
+  static const unsigned int shardCount = 64;
+  // Different sizes counted per shard for the top allocation sizes, any more aren't counted.
+  static const unsigned int sizesPerShard = 32;
+  // Shards add their bytes to the shared total used for the peak once this many have built up,
+  // so the peak can be short by up to this much per shard.
+  static const long long peakGranularity = 16 * 1024;
+
+  static std::size_t getTotalSize() { return static_cast<std::size_t>(sumShards(&Shard::liveBytes)); }
+  static std::size_t getAllocationCount() { return static_cast<std::size_t>(sumShards(&Shard::liveAllocations)); }
+  static std::size_t getPeakSize();
+  static std::vector<std::pair<std::size_t, long long>> getTopAllocationSizes(const unsigned int n);
+  static MemorySnapshot snapshot();
+  static void setHistogramEnabled(const bool enabled) { histogramEnabled.store(enabled, std::memory_order_relaxed); }
+  static std::size_t getSizeClassCount(const unsigned int sizeClass);
+  static unsigned int sizeClassOf(std::size_t bytes) {
+    unsigned int sizeClass = 0;
+    for (bytes = bytes > 0 ? bytes - 1 : 0; bytes > 0; bytes >>= 1) {
+      sizeClass++;
     }
-    return total;
+    return sizeClass;
   }
 
   // I overloaded the new and delete keywords so I could manually track allocated memory.
-  void* operator new(std::size_t x) {
-    void* ptr = ::operator new(x);
-    mapOfAllocations[ptr] = x;
-    return ptr;
-  }
-  void* operator new[](std::size_t x) {
-    void* ptr = ::operator new[](x);
-    mapOfAllocations[ptr] = x;
-    return ptr;
-  }
+  void* operator new(std::size_t x) { return track(::operator new(x + headerSize), x); }
+  void* operator new[](std::size_t x) { return track(::operator new[](x + headerSize), x); }
   void operator delete(void* x) {
-    mapOfAllocations.erase(x);
-    ::operator delete(x);
+    if (x) {
+      ::operator delete(untrack(x));
+    }
   }
   void operator delete[](void* x) {
-    mapOfAllocations.erase(x);
-    ::operator delete[](x);
+    if (x) {
+      ::operator delete[](untrack(x));
+    }
   }
 
 private:
-  static std::map<void*, std::size_t> mapOfAllocations;
+  // Keeps what comes after the header aligned for any type.
+  static const std::size_t headerSize = alignof(std::max_align_t);
+
+  // The header holds the size, and whether the allocation was counted in the histogram.
+  struct Header {
+    std::size_t size;
+    bool inHistogram;
+  };
+  static_assert(sizeof(Header) <= headerSize, "the header has to fit in front of the allocation");
+
+  // Counts can go negative in a shard when memory is freed on a different thread than it was
+  // allocated on, only the sum over all shards means anything.  A shard keeps its counts when
+  // its thread ends and is handed to the next thread that needs one.
+  struct alignas(64) Shard {
+    std::atomic<bool> claimed{ false };
+    std::atomic<long long> liveBytes{ 0 };
+    std::atomic<long long> liveAllocations{ 0 };
+    std::atomic<long long> allocations{ 0 };
+    std::atomic<long long> unpublishedBytes{ 0 };
+    std::atomic<long long> sizeClassHistogram[sizeClassCount]{};
+    // A size of 0 is a free slot, a slot is claimed once and then never changes size.
+    std::atomic<std::size_t> sizes[sizesPerShard]{};
+    std::atomic<long long> sizeCounts[sizesPerShard]{};
+  };
+
+  // A thread's hold on a shard.  Only the thread holding a shard writes to it, unless it is the
+  // shared one, so its counters can be bumped without a locked instruction.  It has no destructor,
+  // so it is still there for anything the thread frees after its ShardRelease has run.
+  struct ShardClaim {
+    Shard* shard;
+    bool exclusive;
+  };
+  // Gives a thread's shard back when the thread ends.  Whatever the thread frees after that, in
+  // other thread_local destructors, is counted in the shared shard.
+  struct ShardRelease {
+    ShardClaim* claim;
+    ~ShardRelease() {
+      if (claim->exclusive) {
+        claim->exclusive = false;
+        claim->shard->claimed.store(false, std::memory_order_release);
+      }
+      claim->shard = &shards[shardCount - 1];
+    }
+  };
+
+  static ShardClaim claimShard();
+  static const ShardClaim& currentShard() {
+    thread_local ShardClaim claim{ nullptr, false };
+    if (claim.shard == nullptr) {
+      claim = claimShard();
+      thread_local ShardRelease release{ &claim };
+      (void)release;
+    }
+    return claim;
+  }
+  static void bump(const ShardClaim& claim, std::atomic<long long>& counter, const long long by) {
+    if (claim.exclusive) {
+      counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    } else {
+      counter.fetch_add(by, std::memory_order_relaxed);
+    }
+  }
+  static long long sumShards(std::atomic<long long> Shard::*counter) {
+    long long total = 0;
+    for (Shard& shard : shards) {
+      total += (shard.*counter).load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+  static void countSize(const ShardClaim& claim, const std::size_t size);
+  static void publishBytes(const ShardClaim& claim, const long long bytes);
+
+  static void* track(void* block, const std::size_t x) {
+    Header* header = static_cast<Header*>(block);
+    header->size = x;
+    header->inHistogram = histogramEnabled.load(std::memory_order_relaxed);
+    const ShardClaim& claim = currentShard();
+    bump(claim, claim.shard->liveBytes, static_cast<long long>(x));
+    bump(claim, claim.shard->liveAllocations, 1);
+    bump(claim, claim.shard->allocations, 1);
+    if (header->inHistogram) {
+      bump(claim, claim.shard->sizeClassHistogram[sizeClassOf(x)], 1);
+    }
+    countSize(claim, x);
+    publishBytes(claim, static_cast<long long>(x));
+    return static_cast<char*>(block) + headerSize;
+  }
+  static void* untrack(void* x) {
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(x) - headerSize);
+    const ShardClaim& claim = currentShard();
+    bump(claim, claim.shard->liveBytes, -static_cast<long long>(header->size));
+    bump(claim, claim.shard->liveAllocations, -1);
+    if (header->inHistogram) {
+      bump(claim, claim.shard->sizeClassHistogram[sizeClassOf(header->size)], -1);
+    }
+    publishBytes(claim, -static_cast<long long>(header->size));
+    return header;
+  }
+
+  static Shard shards[shardCount];
+  static std::atomic<bool> histogramEnabled;
+  static std::atomic<long long> publishedBytes;
+  static std::atomic<long long> peakBytes;
 };
-std::map<void*, std::size_t> ManageMemory::mapOfAllocations;
+ManageMemory::Shard ManageMemory::shards[ManageMemory::shardCount];
+std::atomic<bool> ManageMemory::histogramEnabled{ false };
+std::atomic<long long> ManageMemory::publishedBytes{ 0 };
+std::atomic<long long> ManageMemory::peakBytes{ 0 };
+
+ManageMemory::ShardClaim ManageMemory::claimShard() {
+  for (unsigned int i = 0; i < shardCount - 1; i++) {
+    bool claimed = false;
+    if (shards[i].claimed.compare_exchange_strong(claimed, true, std::memory_order_acquire)) {
+      return ShardClaim{ &shards[i], true };
+    }
+  }
+  return ShardClaim{ &shards[shardCount - 1], false };
+}
+
+void ManageMemory::countSize(const ShardClaim& claim, const std::size_t size) {
+  Shard& shard = *claim.shard;
+  for (unsigned int i = 0; i < sizesPerShard; i++) {
+    std::size_t slotSize = shard.sizes[i].load(std::memory_order_relaxed);
+    if (slotSize == 0 && shard.sizes[i].compare_exchange_strong(slotSize, size, std::memory_order_relaxed)) {
+      slotSize = size;
+    }
+    if (slotSize == size) {
+      bump(claim, shard.sizeCounts[i], 1);
+      return;
+    }
+  }
+}
+
+// Moves the bytes a shard has built up into the shared total once there are enough of them,
+// and raises the peak if that total is higher than it has been.
+void ManageMemory::publishBytes(const ShardClaim& claim, const long long bytes) {
+  std::atomic<long long>& unpublishedBytes = claim.shard->unpublishedBytes;
+  bump(claim, unpublishedBytes, bytes);
+  const long long unpublished = unpublishedBytes.load(std::memory_order_relaxed);
+  if (unpublished < peakGranularity && unpublished > -peakGranularity) {
+    return;
+  }
+  const long long taken = unpublishedBytes.exchange(0, std::memory_order_relaxed);
+  const long long total = publishedBytes.fetch_add(taken, std::memory_order_relaxed) + taken;
+  long long peak = peakBytes.load(std::memory_order_relaxed);
+  while (total > peak && !peakBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+  }
+}
+
+std::size_t ManageMemory::getPeakSize() {
+  // The exact total can be higher than any peak published so far.
+  const long long live = sumShards(&Shard::liveBytes);
+  long long peak = peakBytes.load(std::memory_order_relaxed);
+  while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+  return static_cast<std::size_t>(peak > live ? peak : live);
+}
+
+std::size_t ManageMemory::getSizeClassCount(const unsigned int sizeClass) {
+  if (sizeClass >= sizeClassCount) {
+    return 0;
+  }
+  long long total = 0;
+  for (Shard& shard : shards) {
+    total += shard.sizeClassHistogram[sizeClass].load(std::memory_order_relaxed);
+  }
+  return static_cast<std::size_t>(total);
+}
+
+std::vector<std::pair<std::size_t, long long>> ManageMemory::getTopAllocationSizes(const unsigned int n) {
+  std::map<std::size_t, long long> counts;
+  for (Shard& shard : shards) {
+    for (unsigned int i = 0; i < sizesPerShard; i++) {
+      const std::size_t size = shard.sizes[i].load(std::memory_order_relaxed);
+      if (size != 0) {
+        counts[size] += shard.sizeCounts[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  std::vector<std::pair<std::size_t, long long>> top(counts.begin(), counts.end());
+  std::stable_sort(top.begin(), top.end(), [](const std::pair<std::size_t, long long>& a, const std::pair<std::size_t, long long>& b) {
+    return a.second > b.second;
+  });
+  if (top.size() > n) {
+    top.resize(n);
+  }
+  return top;
+}
+
+MemorySnapshot ManageMemory::snapshot() {
+  MemorySnapshot result;
+  result.liveBytes = sumShards(&Shard::liveBytes);
+  result.liveAllocations = sumShards(&Shard::liveAllocations);
+  result.allocations = sumShards(&Shard::allocations);
+  result.peakBytes = getPeakSize();
+  result.allocationSizes = getTopAllocationSizes(sizesPerShard * shardCount);
+  return result;
+}
+
+MemorySnapshot MemorySnapshot::diff(const MemorySnapshot& earlier) const {
+  MemorySnapshot result;
+  result.liveBytes = this->liveBytes - earlier.liveBytes;
+  result.liveAllocations = this->liveAllocations - earlier.liveAllocations;
+  result.allocations = this->allocations - earlier.allocations;
+  result.peakBytes = this->peakBytes;
+  std::map<std::size_t, long long> counts;
+  for (const std::pair<std::size_t, long long>& size : this->allocationSizes) {
+    counts[size.first] += size.second;
+  }
+  for (const std::pair<std::size_t, long long>& size : earlier.allocationSizes) {
+    counts[size.first] -= size.second;
+  }
+  for (const std::pair<const std::size_t, long long>& size : counts) {
+    if (size.second != 0) {
+      result.allocationSizes.push_back(size);
+    }
+  }
+  std::stable_sort(result.allocationSizes.begin(), result.allocationSizes.end(),
+                   [](const std::pair<std::size_t, long long>& a, const std::pair<std::size_t, long long>& b) {
+                     return a.second > b.second;
+                   });
+  return result;
+}
 
 //******************
 // The node class
@@ -65,6 +331,75 @@ public:
   Node<T>* forward{ nullptr };
 };
 
+//******************
+// Helpers for writing list items as text without a stringstream.
+// They print items the same way `ostream << item` would, with numbers going
+// through std::to_chars so nothing is allocated for them.
+//******************
+const std::size_t numberTextSize = 32;
+
+template <typename T>
+std::size_t formatNumber(char* buffer, const T& value) {
+  std::to_chars_result result;
+  if constexpr (std::is_floating_point<T>::value) {
+    // An ostream's default is %g with 6 significant digits.
+    result = std::to_chars(buffer, buffer + numberTextSize, value, std::chars_format::general, 6);
+  } else {
+    result = std::to_chars(buffer, buffer + numberTextSize, value);
+  }
+  return result.ptr - buffer;
+}
+
+template <typename T>
+const bool printsAsCharacter = std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value;
+
+template <typename T>
+std::size_t itemTextLength(const T& item) {
+  if constexpr (std::is_same<T, bool>::value || printsAsCharacter<T>) {
+    return 1;
+  } else if constexpr (std::is_arithmetic<T>::value) {
+    char buffer[numberTextSize];
+    return formatNumber(buffer, item);
+  } else if constexpr (std::is_same<T, string>::value) {
+    return item.size();
+  } else {
+    stringstream ss;
+    ss << item;
+    return ss.str().size();
+  }
+}
+
+template <typename OutputIt, typename T>
+OutputIt writeItemText(OutputIt out, const T& item) {
+  if constexpr (std::is_same<T, bool>::value) {
+    *out++ = item ? '1' : '0';
+    return out;
+  } else if constexpr (printsAsCharacter<T>) {
+    *out++ = static_cast<char>(item);
+    return out;
+  } else if constexpr (std::is_arithmetic<T>::value) {
+    char buffer[numberTextSize];
+    return std::copy(buffer, buffer + formatNumber(buffer, item), out);
+  } else if constexpr (std::is_same<T, string>::value) {
+    return std::copy(item.begin(), item.end(), out);
+  } else {
+    stringstream ss;
+    ss << item;
+    string text = ss.str();
+    return std::copy(text.begin(), text.end(), out);
+  }
+}
+
+template <typename OutputIt>
+OutputIt writeText(OutputIt out, const char* text) {
+  while (*text) {
+    *out++ = *text++;
+  }
+  return out;
+}
+
+const char emptyListText[] = "The list is empty.";
+
 //******************
 // The linked list base class
 // This contains within it a class declaration for an iterator
@@ -72,12 +407,92 @@ public:
 template <typename T>
 class BaseDoublyLinkedList : public ManageMemory {
 public:
+  // A bidirectional iterator over the items, first to last.  end() holds no node, and stepping
+  // back from it lands on the last one.  IsConst picks between the iterator and const_iterator.
+  template <bool IsConst>
+  class Iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = typename std::conditional<IsConst, const T*, T*>::type;
+    using reference = typename std::conditional<IsConst, const T&, T&>::type;
+
+    Iterator() = default;
+    // An iterator can become a const_iterator, not the other way around.
+    template <bool WasConst, typename = typename std::enable_if<IsConst && !WasConst>::type>
+    Iterator(const Iterator<WasConst>& other) : list(other.list), node(other.node) {}
+
+    reference operator*() const { return node->data; }
+    pointer operator->() const { return &node->data; }
+    Iterator& operator++() {
+      node = node->forward;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator temp = *this;
+      node = node->forward;
+      return temp;
+    }
+    Iterator& operator--() {
+      node = node ? node->backward : list->last;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator temp = *this;
+      --*this;
+      return temp;
+    }
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.node == b.node; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.node != b.node; }
+
+  private:
+    friend class BaseDoublyLinkedList<T>;
+    template <bool>
+    friend class Iterator;
+    explicit Iterator(const BaseDoublyLinkedList<T>* list, Node<T>* node) : list(list), node(node) {}
+
+    const BaseDoublyLinkedList<T>* list{ nullptr };
+    Node<T>* node{ nullptr };
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
   // public members of the DoublyLinkedList class
   ~BaseDoublyLinkedList();
+  iterator begin() { return iterator(this, first); }
+  iterator end() { return iterator(this, nullptr); }
+  const_iterator begin() const { return const_iterator(this, first); }
+  const_iterator end() const { return const_iterator(this, nullptr); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+  const_reverse_iterator crend() const { return rend(); }
+  iterator insert(const_iterator position, const T& value);
+  iterator erase(const_iterator position);
+  void splice(const_iterator position, BaseDoublyLinkedList<T>& other);
+  void splice(const_iterator position, BaseDoublyLinkedList<T>& other, const_iterator from, const_iterator to);
   string getListAsString();
   string getListBackwardsAsString();
+  std::size_t getStringLength() const;
+  template <typename OutputIt>
+  OutputIt writeList(OutputIt out) const;
+  template <typename OutputIt>
+  OutputIt writeListBackwards(OutputIt out) const;
+  std::size_t writeList(char* buffer, const std::size_t bufferSize) const;
+  std::size_t writeListBackwards(char* buffer, const std::size_t bufferSize) const;
   void insertFirst(const T&);
   void insertLast(const T&);
+  unsigned int size() const { return count; }
+  // At most this many removed nodes are kept for reuse, any more are deleted.
+  static const unsigned int maxSpareNodes = 64;
+  void releaseSpareNodes();
   T get(const unsigned int index) const {
     cerr << "Error: You didn't override this base class method yet" << endl;
     T temp{};
@@ -93,8 +508,23 @@ public:
   void removeAllInstances(const T& value) { cerr << "Error: You didn't override this base class method yet" << endl; }
 
 protected:
+  template <typename OutputIt>
+  OutputIt writeNodes(OutputIt out, const bool backwards) const;
+  Node<T>* acquireNode();
+  void recycleNodes(Node<T>* runFirst, Node<T>* runLast);
+  void linkBefore(Node<T>* position, Node<T>* runFirst, Node<T>* runLast);
+  void unlink(Node<T>* runFirst, Node<T>* runLast);
+
   Node<T>* first{ nullptr };
   Node<T>* last{ nullptr };
+  unsigned int count{ 0 };
+  // The node most recently reached by index, so walking the list in order
+  // doesn't start over from one end every time.  nullptr when there isn't one.
+  mutable Node<T>* cursor{ nullptr };
+  mutable unsigned int cursorIndex{ 0 };
+  // Removed nodes, chained through forward, waiting to be reused by the next insert.
+  Node<T>* spareNodes{ nullptr };
+  unsigned int spareCount{ 0 };
 };
 
 template <typename T> // destructor
@@ -106,11 +536,58 @@ BaseDoublyLinkedList<T>::~BaseDoublyLinkedList() {
     delete temp;
     temp = first;
   }
+  releaseSpareNodes();
+}
+
+// Gives the memory of the nodes kept for reuse back.
+template <typename T>
+void BaseDoublyLinkedList<T>::releaseSpareNodes() {
+  while (spareNodes) {
+    Node<T>* temp = spareNodes;
+    spareNodes = spareNodes->forward;
+    delete temp;
+  }
+  spareCount = 0;
+}
+
+// Hands out a spare node if there is one, otherwise a new one.  Its links are cleared either way.
+template <typename T>
+Node<T>* BaseDoublyLinkedList<T>::acquireNode() {
+  if (!spareNodes) {
+    return new Node<T>();
+  }
+  Node<T>* temp = spareNodes;
+  spareNodes = spareNodes->forward;
+  spareCount--;
+  temp->forward = nullptr;
+  temp->backward = nullptr;
+  return temp;
+}
+
+// Keeps an already unlinked run of nodes, still chained first to last through forward, for reuse.
+// A kept node's item is swapped out for an empty one and destroyed, so a spare holds no string
+// or shared_ptr alive, and nodes past maxSpareNodes are deleted.
+template <typename T>
+void BaseDoublyLinkedList<T>::recycleNodes(Node<T>* runFirst, Node<T>* runLast) {
+  Node<T>* node = runFirst;
+  while (node) {
+    Node<T>* next = node == runLast ? nullptr : node->forward;
+    if (spareCount < maxSpareNodes) {
+      T released{};
+      std::swap(node->data, released);
+      node->forward = spareNodes;
+      spareNodes = node;
+      spareCount++;
+    } else {
+      delete node;
+    }
+    node = next;
+  }
 }
 
 template <typename T>
 void BaseDoublyLinkedList<T>::insertFirst(const T& item) {
-  Node<T>* temp = new Node<T>();
+  Node<T>* temp = acquireNode();
 
   temp->data = item;
   if (!first) {
@@ -121,11 +598,15 @@ void BaseDoublyLinkedList<T>::insertFirst(const T& item) {
     temp->forward = first;
   }
   first = temp;
+  count++;
+  if (cursor) {
+    cursorIndex++;
+  }
 }
 
 template <typename T>
 void BaseDoublyLinkedList<T>::insertLast(const T& item) {
-  Node<T>* temp = new Node<T>();
+  Node<T>* temp = acquireNode();
 
   temp->data = item;
   if (!first) {
@@ -136,46 +617,181 @@ void BaseDoublyLinkedList<T>::insertLast(const T& item) {
     temp->backward = last;
   }
   last = temp;
+  count++;
 }
 
-// This method helps return a string representation of all nodes in the linked list, do not modify.
+// Links a run of nodes, already chained to each other, in before position, or at the end for nullptr.
 template <typename T>
-string BaseDoublyLinkedList<T>::getListAsString() {
-  stringstream ss;
-  if (!first) {
-    ss << "The list is empty.";
+void BaseDoublyLinkedList<T>::linkBefore(Node<T>* position, Node<T>* runFirst, Node<T>* runLast) {
+  Node<T>* before = position ? position->backward : last;
+  runFirst->backward = before;
+  runLast->forward = position;
+  if (before) {
+    before->forward = runFirst;
+  } else {
+    first = runFirst;
+  }
+  if (position) {
+    position->backward = runLast;
   } else {
+    last = runLast;
+  }
+}
 
-    Node<T>* currentNode{ first };
-    ss << currentNode->data;
-    currentNode = currentNode->forward;
+// Takes a run of nodes out of the list, leaving them chained to each other.
+template <typename T>
+void BaseDoublyLinkedList<T>::unlink(Node<T>* runFirst, Node<T>* runLast) {
+  if (runFirst->backward) {
+    runFirst->backward->forward = runLast->forward;
+  } else {
+    first = runLast->forward;
+  }
+  if (runLast->forward) {
+    runLast->forward->backward = runFirst->backward;
+  } else {
+    last = runFirst->backward;
+  }
+}
 
-    while (currentNode) {
-      ss << " " << currentNode->data;
-      currentNode = currentNode->forward;
-    };
+// Inserts value before position, and returns an iterator to it.
+// Index positions move around here, so the cursor is dropped.
+template <typename T>
+typename BaseDoublyLinkedList<T>::iterator BaseDoublyLinkedList<T>::insert(const_iterator position, const T& value) {
+  Node<T>* temp = acquireNode();
+  temp->data = value;
+  linkBefore(position.node, temp, temp);
+  count++;
+  cursor = nullptr;
+  return iterator(this, temp);
+}
+
+// Removes the item at position, and returns an iterator to the item after it.
+template <typename T>
+typename BaseDoublyLinkedList<T>::iterator BaseDoublyLinkedList<T>::erase(const_iterator position) {
+  Node<T>* temp = position.node;
+  Node<T>* after = temp->forward;
+  unlink(temp, temp);
+  recycleNodes(temp, temp);
+  count--;
+  cursor = nullptr;
+  return iterator(this, after);
+}
+
+// Moves every node of other in before position, leaving other empty.  Nothing is copied or allocated.
+template <typename T>
+void BaseDoublyLinkedList<T>::splice(const_iterator position, BaseDoublyLinkedList<T>& other) {
+  if (&other == this || !other.first) {
+    return;
   }
-  return ss.str();
+  linkBefore(position.node, other.first, other.last);
+  count += other.count;
+  cursor = nullptr;
+  other.first = nullptr;
+  other.last = nullptr;
+  other.count = 0;
+  other.cursor = nullptr;
 }
 
-// This method helps return a string representation of all nodes in the linked list, do not modify.
+// Moves the nodes of other from from up to, but not including, to in before position.
+// The nodes are counted on the way, so this takes as long as the range is.
+template <typename T>
+void BaseDoublyLinkedList<T>::splice(const_iterator position, BaseDoublyLinkedList<T>& other, const_iterator from, const_iterator to) {
+  if (from == to) {
+    return;
+  }
+  Node<T>* runFirst = from.node;
+  Node<T>* runLast = to.node ? to.node->backward : other.last;
+  unsigned int moved = 1;
+  for (Node<T>* currentNode = runFirst; currentNode != runLast; currentNode = currentNode->forward) {
+    moved++;
+  }
+  other.unlink(runFirst, runLast);
+  other.count -= moved;
+  other.cursor = nullptr;
+  linkBefore(position.node, runFirst, runLast);
+  count += moved;
+  cursor = nullptr;
+}
+
+// This method helps return a string representation of all nodes in the linked list.
+// It sizes the string up front and fills it with writeList(), so it allocates once.
+template <typename T>
+string BaseDoublyLinkedList<T>::getListAsString() {
+  string result(this->getStringLength(), ' ');
+  this->writeList(&result[0]);
+  return result;
+}
+
+// This method helps return a string representation of all nodes in the linked list, last to first.
 template <typename T>
 string BaseDoublyLinkedList<T>::getListBackwardsAsString() {
-  stringstream ss;
+  string result(this->getStringLength(), ' ');
+  this->writeListBackwards(&result[0]);
+  return result;
+}
+
+// The length of what getListAsString() and getListBackwardsAsString() return, worked out without building them.
+template <typename T>
+std::size_t BaseDoublyLinkedList<T>::getStringLength() const {
   if (!first) {
-    ss << "The list is empty.";
-  } else {
+    return sizeof(emptyListText) - 1;
+  }
+  std::size_t length = 0;
+  for (Node<T>* currentNode = first; currentNode; currentNode = currentNode->forward) {
+    length += itemTextLength(currentNode->data) + 1;
+  }
+  // One less space than there are items.
+  return length - 1;
+}
 
-    Node<T>* currentNode{ last };
-    ss << currentNode->data;
-    currentNode = currentNode->backward;
+template <typename T>
+template <typename OutputIt>
+OutputIt BaseDoublyLinkedList<T>::writeNodes(OutputIt out, const bool backwards) const {
+  if (!first) {
+    return writeText(out, emptyListText);
+  }
+  Node<T>* currentNode = backwards ? last : first;
+  out = writeItemText(out, currentNode->data);
+  currentNode = backwards ? currentNode->backward : currentNode->forward;
+  while (currentNode) {
+    *out++ = ' ';
+    out = writeItemText(out, currentNode->data);
+    currentNode = backwards ? currentNode->backward : currentNode->forward;
+  }
+  return out;
+}
+
+// Writes the same text as getListAsString() through an output iterator, and returns the iterator.
+template <typename T>
+template <typename OutputIt>
+OutputIt BaseDoublyLinkedList<T>::writeList(OutputIt out) const {
+  return this->writeNodes(out, false);
+}
+
+template <typename T>
+template <typename OutputIt>
+OutputIt BaseDoublyLinkedList<T>::writeListBackwards(OutputIt out) const {
+  return this->writeNodes(out, true);
+}
+
+// Writes the text into the caller's buffer, without a terminating null, and returns its length.
+// If the buffer is too small nothing is written, and the length says how much room is needed.
+template <typename T>
+std::size_t BaseDoublyLinkedList<T>::writeList(char* buffer, const std::size_t bufferSize) const {
+  std::size_t length = this->getStringLength();
+  if (length <= bufferSize) {
+    this->writeNodes(buffer, false);
+  }
+  return length;
+}
 
-    while (currentNode) {
-      ss << " " << currentNode->data;
-      currentNode = currentNode->backward;
-    };
+template <typename T>
+std::size_t BaseDoublyLinkedList<T>::writeListBackwards(char* buffer, const std::size_t bufferSize) const {
+  std::size_t length = this->getStringLength();
+  if (length <= bufferSize) {
+    this->writeNodes(buffer, true);
   }
-  return ss.str();
+  return length;
 }
 
 // Copyright 2020, Bradley Peterson, Weber State University, All rights reserved. (2/20)
@@ -186,165 +802,565 @@ string BaseDoublyLinkedList<T>::getListBackwardsAsString() {
 template <typename T>
 class DoublyLinkedList : public BaseDoublyLinkedList<T> {
 public:
+  using BaseDoublyLinkedList<T>::insert;
   T get(const unsigned int) const;
   T& operator[](const unsigned int) const;
   void insert(const unsigned int, const T&);
   void remove(const unsigned int);
   void removeAllInstances(const T&);
+  template <typename Predicate>
+  unsigned int remove_if(Predicate);
+
+private:
+  Node<T>* seek(const unsigned int) const;
 };
 
+// Finds the node at index, which must be in range.  It walks from whichever of
+// first, last, or the cursor is closest, so stepping through the list by index
+// in either direction only moves one node per call.
 template <typename T>
-T DoublyLinkedList<T>::get(const unsigned int index) const {
-  if (this->first == nullptr) {
-    throw 1;
-  }
+Node<T>* DoublyLinkedList<T>::seek(const unsigned int index) const {
   Node<T>* currentNode = this->first;
   unsigned int position = 0;
-  while (currentNode->forward != nullptr) {
-    if (position == index) {
-      break;
+  unsigned int distance = index;
+  if (this->count - 1 - index < distance) {
+    currentNode = this->last;
+    position = this->count - 1;
+    distance = this->count - 1 - index;
+  }
+  if (this->cursor) {
+    unsigned int cursorDistance = index > this->cursorIndex ? index - this->cursorIndex : this->cursorIndex - index;
+    if (cursorDistance < distance) {
+      currentNode = this->cursor;
+      position = this->cursorIndex;
     }
+  }
+  while (position < index) {
     currentNode = currentNode->forward;
     position++;
   }
-  if (position < index) {
+  while (position > index) {
+    currentNode = currentNode->backward;
+    position--;
+  }
+  this->cursor = currentNode;
+  this->cursorIndex = index;
+  return currentNode;
+}
+
+template <typename T>
+T DoublyLinkedList<T>::get(const unsigned int index) const {
+  if (index >= this->count) {
     throw 1;
   }
-  return currentNode->data;
+  return this->seek(index)->data;
 }
 
 template <typename T>
 T& DoublyLinkedList<T>::operator[](const unsigned int index) const {
-  if (this->first == nullptr) {
+  if (index >= this->count) {
     throw 1;
   }
+  return this->seek(index)->data;
+}
+
+// Inserts value so it ends up at index.  An index past the end appends it.
+template <typename T>
+void DoublyLinkedList<T>::insert(const unsigned int index, const T& value) {
+  if (index == 0) {
+    this->insertFirst(value);
+    return;
+  }
+  if (index >= this->count) {
+    this->insertLast(value);
+    return;
+  }
+
+  Node<T>* currentNode = this->seek(index);
+  Node<T>* newNode = this->acquireNode();
+  newNode->data = value;
+  currentNode->backward->forward = newNode;
+  newNode->backward = currentNode->backward;
+  newNode->forward = currentNode;
+  currentNode->backward = newNode;
+  this->count++;
+  // The cursor was on the node that just moved up one.
+  this->cursorIndex++;
+}
+
+template <typename T>
+void DoublyLinkedList<T>::remove(const unsigned int index) {
+  if (index >= this->count) {
+    return;
+  }
+
+  Node<T>* currentNode = this->seek(index);
+  this->unlink(currentNode, currentNode);
+  // Leave the cursor on the node that moved down into this index, if there is one.
+  this->cursor = currentNode->forward;
+  this->recycleNodes(currentNode, currentNode);
+  this->count--;
+}
+
+template <typename T>
+void DoublyLinkedList<T>::removeAllInstances(const T& value) {
+  this->remove_if([&value](const T& data) { return data == value; });
+}
+
+// Removes every item the predicate is true for in one pass, and returns how many were removed.
+// Each run of neighboring matches is unlinked with a single relink and recycled as a whole.
+template <typename T>
+template <typename Predicate>
+unsigned int DoublyLinkedList<T>::remove_if(Predicate shouldRemove) {
+  unsigned int removed = 0;
   Node<T>* currentNode = this->first;
+  while (currentNode) {
+    if (!shouldRemove(currentNode->data)) {
+      currentNode = currentNode->forward;
+      continue;
+    }
+
+    // Find where this run of matches ends.
+    Node<T>* runFirst = currentNode;
+    Node<T>* runLast = currentNode;
+    removed++;
+    while (runLast->forward && shouldRemove(runLast->forward->data)) {
+      runLast = runLast->forward;
+      removed++;
+    }
+
+    Node<T>* after = runLast->forward;
+    this->unlink(runFirst, runLast);
+    this->recycleNodes(runFirst, runLast);
+    currentNode = after;
+  }
+  if (removed > 0) {
+    this->count -= removed;
+    this->cursor = nullptr;
+  }
+  return removed;
+}
+
+//******************
+// A DoublyLinkedList with the same interface whose nodes live side by side in one vector,
+// linked by 32 bit slot numbers instead of pointers, so walking it touches far fewer cache
+// lines.  Removed slots go on a free list and are filled again by the next insert, and
+// compact() lays the slots out in list order again once inserts and removes have scattered them.
+//******************
+template <typename T>
+class ArenaDoublyLinkedList : public ManageMemory {
+public:
+  template <bool IsConst>
+  class Iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = typename std::conditional<IsConst, const T*, T*>::type;
+    using reference = typename std::conditional<IsConst, const T&, T&>::type;
+
+    Iterator() = default;
+    template <bool WasConst, typename = typename std::enable_if<IsConst && !WasConst>::type>
+    Iterator(const Iterator<WasConst>& other) : list(other.list), slot(other.slot) {}
+
+    reference operator*() const { return list->slots[slot].data; }
+    pointer operator->() const { return &list->slots[slot].data; }
+    Iterator& operator++() {
+      slot = list->slots[slot].forward;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator temp = *this;
+      ++*this;
+      return temp;
+    }
+    Iterator& operator--() {
+      slot = slot != noSlot ? list->slots[slot].backward : list->last;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator temp = *this;
+      --*this;
+      return temp;
+    }
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.slot == b.slot; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.slot != b.slot; }
+
+  private:
+    friend class ArenaDoublyLinkedList<T>;
+    template <bool>
+    friend class Iterator;
+    using List = typename std::conditional<IsConst, const ArenaDoublyLinkedList<T>, ArenaDoublyLinkedList<T>>::type;
+    explicit Iterator(List* list, std::uint32_t slot) : list(list), slot(slot) {}
+
+    List* list{ nullptr };
+    std::uint32_t slot{ noSlot };
+  };
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  iterator begin() { return iterator(this, first); }
+  iterator end() { return iterator(this, noSlot); }
+  const_iterator begin() const { return const_iterator(this, first); }
+  const_iterator end() const { return const_iterator(this, noSlot); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  string getListAsString();
+  string getListBackwardsAsString();
+  std::size_t getStringLength() const;
+  template <typename OutputIt>
+  OutputIt writeList(OutputIt out) const;
+  template <typename OutputIt>
+  OutputIt writeListBackwards(OutputIt out) const;
+  std::size_t writeList(char* buffer, const std::size_t bufferSize) const;
+  std::size_t writeListBackwards(char* buffer, const std::size_t bufferSize) const;
+  void insertFirst(const T&);
+  void insertLast(const T&);
+  unsigned int size() const { return count; }
+  T get(const unsigned int) const;
+  T& operator[](const unsigned int);
+  const T& operator[](const unsigned int) const;
+  void insert(const unsigned int, const T&);
+  iterator insert(const_iterator position, const T& value);
+  void remove(const unsigned int);
+  iterator erase(const_iterator position);
+  void removeAllInstances(const T&);
+  template <typename Predicate>
+  unsigned int remove_if(Predicate);
+  void reserve(const unsigned int capacity) { slots.reserve(capacity); }
+  unsigned int getSlotCount() const { return static_cast<unsigned int>(slots.size()); }
+  void compact();
+
+private:
+  static const std::uint32_t noSlot = 0xFFFFFFFF;
+
+  struct Slot {
+    T data{};
+    std::uint32_t backward{ noSlot };
+    std::uint32_t forward{ noSlot };
+  };
+
+  template <typename OutputIt>
+  OutputIt writeSlots(OutputIt out, const bool backwards) const;
+  std::uint32_t acquireSlot(const T& value);
+  void linkBefore(const std::uint32_t position, const std::uint32_t slot);
+  void unlink(const std::uint32_t runFirst, const std::uint32_t runLast);
+  std::uint32_t seek(const unsigned int) const;
+
+  std::vector<Slot> slots;
+  std::uint32_t first{ noSlot };
+  std::uint32_t last{ noSlot };
+  // Emptied slots, chained through forward, waiting to be reused by the next insert.
+  std::uint32_t freeSlots{ noSlot };
+  unsigned int count{ 0 };
+  // The slot most recently reached by index, the same as DoublyLinkedList keeps.
+  mutable std::uint32_t cursor{ noSlot };
+  mutable unsigned int cursorIndex{ 0 };
+};
+
+// Fills a free slot with value, or adds one to the end of the vector.  It isn't linked in yet.
+template <typename T>
+std::uint32_t ArenaDoublyLinkedList<T>::acquireSlot(const T& value) {
+  if (freeSlots == noSlot) {
+    if (slots.size() >= noSlot) {
+      throw 1;
+    }
+    slots.push_back(Slot{ value, noSlot, noSlot });
+    return static_cast<std::uint32_t>(slots.size() - 1);
+  }
+  std::uint32_t slot = freeSlots;
+  freeSlots = slots[slot].forward;
+  slots[slot].data = value;
+  return slot;
+}
+
+// Links a slot in before position, or at the end for noSlot.
+template <typename T>
+void ArenaDoublyLinkedList<T>::linkBefore(const std::uint32_t position, const std::uint32_t slot) {
+  std::uint32_t before = position != noSlot ? slots[position].backward : last;
+  slots[slot].backward = before;
+  slots[slot].forward = position;
+  if (before != noSlot) {
+    slots[before].forward = slot;
+  } else {
+    first = slot;
+  }
+  if (position != noSlot) {
+    slots[position].backward = slot;
+  } else {
+    last = slot;
+  }
+  count++;
+}
+
+// Takes a run of slots out of the list, and chains them onto the free slots.
+template <typename T>
+void ArenaDoublyLinkedList<T>::unlink(const std::uint32_t runFirst, const std::uint32_t runLast) {
+  std::uint32_t before = slots[runFirst].backward;
+  std::uint32_t after = slots[runLast].forward;
+  if (before != noSlot) {
+    slots[before].forward = after;
+  } else {
+    first = after;
+  }
+  if (after != noSlot) {
+    slots[after].backward = before;
+  } else {
+    last = before;
+  }
+  slots[runLast].forward = freeSlots;
+  freeSlots = runFirst;
+}
+
+template <typename T>
+void ArenaDoublyLinkedList<T>::insertFirst(const T& item) {
+  this->linkBefore(first, this->acquireSlot(item));
+  if (cursor != noSlot) {
+    cursorIndex++;
+  }
+}
+
+template <typename T>
+void ArenaDoublyLinkedList<T>::insertLast(const T& item) {
+  this->linkBefore(noSlot, this->acquireSlot(item));
+}
+
+// Finds the slot at index, which must be in range, walking from whichever of first, last, or the cursor is closest.
+template <typename T>
+std::uint32_t ArenaDoublyLinkedList<T>::seek(const unsigned int index) const {
+  std::uint32_t currentSlot = first;
   unsigned int position = 0;
-  while (currentNode->forward != nullptr) {
-    if (position == index) {
-      break;
+  unsigned int distance = index;
+  if (count - 1 - index < distance) {
+    currentSlot = last;
+    position = count - 1;
+    distance = count - 1 - index;
+  }
+  if (cursor != noSlot) {
+    unsigned int cursorDistance = index > cursorIndex ? index - cursorIndex : cursorIndex - index;
+    if (cursorDistance < distance) {
+      currentSlot = cursor;
+      position = cursorIndex;
     }
-    currentNode = currentNode->forward;
+  }
+  while (position < index) {
+    currentSlot = slots[currentSlot].forward;
     position++;
   }
-  if (position < index) {
+  while (position > index) {
+    currentSlot = slots[currentSlot].backward;
+    position--;
+  }
+  cursor = currentSlot;
+  cursorIndex = index;
+  return currentSlot;
+}
+
+template <typename T>
+T ArenaDoublyLinkedList<T>::get(const unsigned int index) const {
+  if (index >= count) {
     throw 1;
   }
-  return currentNode->data;
+  return slots[this->seek(index)].data;
 }
 
 template <typename T>
-void DoublyLinkedList<T>::insert(const unsigned int index, const T& value) {
-  Node<T>* newNode = new Node<T>();
-  newNode->data = value;
+T& ArenaDoublyLinkedList<T>::operator[](const unsigned int index) {
+  if (index >= count) {
+    throw 1;
+  }
+  return slots[this->seek(index)].data;
+}
 
+template <typename T>
+const T& ArenaDoublyLinkedList<T>::operator[](const unsigned int index) const {
+  if (index >= count) {
+    throw 1;
+  }
+  return slots[this->seek(index)].data;
+}
+
+// Inserts value so it ends up at index.  An index past the end appends it.
+template <typename T>
+void ArenaDoublyLinkedList<T>::insert(const unsigned int index, const T& value) {
   if (index == 0) {
-    if (this->first == nullptr && this->last == nullptr) {
-      this->first = newNode;
-      this->last = newNode;
-    } else {
-      newNode->forward = this->first;
-      this->first->backward = newNode;
-      this->first = newNode;
-    }
+    this->insertFirst(value);
     return;
   }
+  if (index >= count) {
+    this->insertLast(value);
+    return;
+  }
+  // Take the slot before seeking, since the vector may grow.
+  std::uint32_t slot = this->acquireSlot(value);
+  this->linkBefore(this->seek(index), slot);
+  // The cursor was on the slot that just moved up one.
+  cursorIndex++;
+}
+
+template <typename T>
+typename ArenaDoublyLinkedList<T>::iterator ArenaDoublyLinkedList<T>::insert(const_iterator position, const T& value) {
+  std::uint32_t slot = this->acquireSlot(value);
+  this->linkBefore(position.slot, slot);
+  cursor = noSlot;
+  return iterator(this, slot);
+}
+
+template <typename T>
+void ArenaDoublyLinkedList<T>::remove(const unsigned int index) {
+  if (index >= count) {
+    return;
+  }
+  std::uint32_t slot = this->seek(index);
+  // Leave the cursor on the slot that moved down into this index, if there is one.
+  cursor = slots[slot].forward;
+  this->unlink(slot, slot);
+  count--;
+}
+
+template <typename T>
+typename ArenaDoublyLinkedList<T>::iterator ArenaDoublyLinkedList<T>::erase(const_iterator position) {
+  std::uint32_t after = slots[position.slot].forward;
+  this->unlink(position.slot, position.slot);
+  count--;
+  cursor = noSlot;
+  return iterator(this, after);
+}
+
+template <typename T>
+void ArenaDoublyLinkedList<T>::removeAllInstances(const T& value) {
+  this->remove_if([&value](const T& data) { return data == value; });
+}
 
-  Node<T>* currentNode = this->first;
-  unsigned int position = 0;
-  while (currentNode->forward != nullptr) {
-    if (position == index) {
-      break;
+// Removes every item the predicate is true for in one pass, a run of neighboring matches at a time.
+template <typename T>
+template <typename Predicate>
+unsigned int ArenaDoublyLinkedList<T>::remove_if(Predicate shouldRemove) {
+  unsigned int removed = 0;
+  std::uint32_t currentSlot = first;
+  while (currentSlot != noSlot) {
+    if (!shouldRemove(slots[currentSlot].data)) {
+      currentSlot = slots[currentSlot].forward;
+      continue;
     }
-    currentNode = currentNode->forward;
-    position++;
+    std::uint32_t runLast = currentSlot;
+    removed++;
+    while (slots[runLast].forward != noSlot && shouldRemove(slots[slots[runLast].forward].data)) {
+      runLast = slots[runLast].forward;
+      removed++;
+    }
+    std::uint32_t after = slots[runLast].forward;
+    this->unlink(currentSlot, runLast);
+    currentSlot = after;
   }
-
-  if (currentNode == this->last) {
-    newNode->backward = currentNode;
-    currentNode->forward = newNode;
-    this->last = newNode;
-  } else {
-    currentNode->backward->forward = newNode;
-    newNode->backward = currentNode->backward;
-    newNode->forward = currentNode;
-    currentNode->backward = newNode;
+  if (removed > 0) {
+    count -= removed;
+    cursor = noSlot;
   }
+  return removed;
 }
 
+// Moves the items into slots numbered in list order, so walking the list reads the vector front
+// to back, and gives up the free slots.  Iterators from before are no longer any good.
 template <typename T>
-void DoublyLinkedList<T>::remove(const unsigned int index) {
-  if (this->first == nullptr) {
-    return;
+void ArenaDoublyLinkedList<T>::compact() {
+  std::vector<Slot> ordered;
+  ordered.reserve(count);
+  for (std::uint32_t currentSlot = first; currentSlot != noSlot; currentSlot = slots[currentSlot].forward) {
+    std::uint32_t slot = static_cast<std::uint32_t>(ordered.size());
+    ordered.push_back(Slot{ std::move(slots[currentSlot].data), slot - 1, slot + 1 });
   }
-
-  Node<T>* currentNode = this->first;
-  if (index == 0 && this->first == this->last) {
-    this->first = nullptr;
-    this->last = nullptr;
-    delete currentNode;
-    return;
-  } else if (index == 0) {
-    currentNode->forward->backward = nullptr;
-    this->first = currentNode->forward;
-    delete currentNode;
-    return;
+  if (!ordered.empty()) {
+    ordered.front().backward = noSlot;
+    ordered.back().forward = noSlot;
   }
+  slots.swap(ordered);
+  first = slots.empty() ? noSlot : 0;
+  last = slots.empty() ? noSlot : static_cast<std::uint32_t>(slots.size() - 1);
+  freeSlots = noSlot;
+  cursor = noSlot;
+}
 
-  unsigned int position = 0;
-  while (currentNode->forward != nullptr) {
-    if (position == index) {
-      break;
-    }
-    currentNode = currentNode->forward;
-    position++;
+template <typename T>
+string ArenaDoublyLinkedList<T>::getListAsString() {
+  string result(this->getStringLength(), ' ');
+  this->writeList(&result[0]);
+  return result;
+}
+
+template <typename T>
+string ArenaDoublyLinkedList<T>::getListBackwardsAsString() {
+  string result(this->getStringLength(), ' ');
+  this->writeListBackwards(&result[0]);
+  return result;
+}
+
+template <typename T>
+std::size_t ArenaDoublyLinkedList<T>::getStringLength() const {
+  if (first == noSlot) {
+    return sizeof(emptyListText) - 1;
   }
-  if (position < index) {
-    return;
+  std::size_t length = 0;
+  for (std::uint32_t currentSlot = first; currentSlot != noSlot; currentSlot = slots[currentSlot].forward) {
+    length += itemTextLength(slots[currentSlot].data) + 1;
   }
+  return length - 1;
+}
 
-  if (currentNode == this->last) {
-    currentNode->backward->forward = nullptr;
-    this->last = currentNode->backward;
-    delete currentNode;
-  } else {
-    currentNode->backward->forward = currentNode->forward;
-    currentNode->forward->backward = currentNode->backward;
-    delete currentNode;
+template <typename T>
+template <typename OutputIt>
+OutputIt ArenaDoublyLinkedList<T>::writeSlots(OutputIt out, const bool backwards) const {
+  if (first == noSlot) {
+    return writeText(out, emptyListText);
   }
+  std::uint32_t currentSlot = backwards ? last : first;
+  out = writeItemText(out, slots[currentSlot].data);
+  currentSlot = backwards ? slots[currentSlot].backward : slots[currentSlot].forward;
+  while (currentSlot != noSlot) {
+    *out++ = ' ';
+    out = writeItemText(out, slots[currentSlot].data);
+    currentSlot = backwards ? slots[currentSlot].backward : slots[currentSlot].forward;
+  }
+  return out;
 }
 
 template <typename T>
-void DoublyLinkedList<T>::removeAllInstances(const T& value) {
-  if (this->first == nullptr) {
-    return;
-  }
+template <typename OutputIt>
+OutputIt ArenaDoublyLinkedList<T>::writeList(OutputIt out) const {
+  return this->writeSlots(out, false);
+}
 
-  Node<T>* currentNode = this->first;
-  if (currentNode == this->first && this->first == this->last) {
-    this->first = nullptr;
-    this->last = nullptr;
-    delete currentNode;
-    return;
+template <typename T>
+template <typename OutputIt>
+OutputIt ArenaDoublyLinkedList<T>::writeListBackwards(OutputIt out) const {
+  return this->writeSlots(out, true);
+}
+
+template <typename T>
+std::size_t ArenaDoublyLinkedList<T>::writeList(char* buffer, const std::size_t bufferSize) const {
+  std::size_t length = this->getStringLength();
+  if (length <= bufferSize) {
+    this->writeSlots(buffer, false);
   }
+  return length;
+}
 
-  while (currentNode != nullptr) {
-    if (currentNode->data == value) {
-      if (currentNode == this->first) {
-        currentNode->forward->backward = nullptr;
-        this->first = currentNode->forward;
-      } else if (currentNode == this->last) {
-        currentNode->backward->forward = nullptr;
-        this->last = currentNode->backward;
-      } else {
-        currentNode->backward->forward = currentNode->forward;
-        currentNode->forward->backward = currentNode->backward;
-      }
-      Node<T>* nodeToDelete = currentNode;
-      delete nodeToDelete;
-    }
-    currentNode = currentNode->forward;
+template <typename T>
+std::size_t ArenaDoublyLinkedList<T>::writeListBackwards(char* buffer, const std::size_t bufferSize) const {
+  std::size_t length = this->getStringLength();
+  if (length <= bufferSize) {
+    this->writeSlots(buffer, true);
   }
+  return length;
 }
 
 //**********************************
@@ -728,6 +1744,682 @@ void testRemoveAllInstances() {
 }
 //911
 
+void testWriteList() {
+  DoublyLinkedList<int> d;
+  checkTest("testWriteList #1", "The list is empty.", d.getListBackwardsAsString());
+  for (int i = -2; i < 12; i += 3) {
+    d.insertLast(i);
+  }
+  checkTest("testWriteList #2", 11, d.getStringLength());
+  char buffer[16] = {};
+  checkTest("testWriteList #3", 11, d.writeListBackwards(buffer, 10));
+  checkTest("testWriteList #4", "", string(buffer));
+  checkTest("testWriteList #5", 11, d.writeListBackwards(buffer, sizeof(buffer)));
+  checkTest("testWriteList #6", "10 7 4 1 -2", string(buffer, 11));
+  string appended = "list: ";
+  d.writeList(std::back_inserter(appended));
+  checkTest("testWriteList #7", "list: -2 1 4 7 10", appended);
+
+  DoublyLinkedList<double> dd;
+  dd.insertLast(3.14159265);
+  dd.insertLast(1e-7);
+  checkTest("testWriteList #8", "3.14159 1e-07", dd.getListAsString());
+}
+
+// The original stringstream version of getListAsString(), to compare against.
+template <typename T>
+class StringstreamDoublyLinkedList : public DoublyLinkedList<T> {
+public:
+  string getListAsStringWithStringstream() {
+    stringstream ss;
+    if (!this->first) {
+      ss << "The list is empty.";
+    } else {
+      Node<T>* currentNode{ this->first };
+      ss << currentNode->data;
+      currentNode = currentNode->forward;
+      while (currentNode) {
+        ss << " " << currentNode->data;
+        currentNode = currentNode->forward;
+      };
+    }
+    return ss.str();
+  }
+};
+
+void benchmarkWriteList() {
+  const int rounds = 10000;
+  StringstreamDoublyLinkedList<int> d;
+  for (int i = 0; i < 100; i++) {
+    d.insertLast(i * 997);
+  }
+  std::size_t total = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    total += d.getListAsStringWithStringstream().size();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> streamTime = end - start;
+
+  char buffer[1024];
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    total += d.writeList(buffer, sizeof(buffer));
+  }
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> bufferTime = end - start;
+
+  cout << "Turning a 100 item list into text 10,000 times took " << (streamTime.count() / 1000.0)
+       << " milliseconds with a stringstream, " << (bufferTime.count() / 1000.0)
+       << " with writeList into a buffer (" << total << " characters)." << endl;
+}
+
+void testIndexedSeek() {
+  DoublyLinkedList<int> d;
+  for (int i = 0; i < 20; i++) {
+    d.insertLast(i);
+  }
+  int total = 0;
+  for (unsigned int i = 0; i < d.size(); i++) {
+    total += d.get(i);
+  }
+  checkTest("testIndexedSeek #1", 190, total);
+  total = 0;
+  for (unsigned int i = d.size(); i > 0; i--) {
+    total += d[i - 1];
+  }
+  checkTest("testIndexedSeek #2", 190, total);
+
+  // Changes in front of the cursor have to keep it pointing at the right index.
+  checkTest("testIndexedSeek #3", 10, d.get(10));
+  d.insertFirst(-1);
+  checkTest("testIndexedSeek #4", 10, d.get(11));
+  d.insert(5, 100);
+  checkTest("testIndexedSeek #5", 100, d.get(5));
+  checkTest("testIndexedSeek #6", 4, d.get(6));
+  d.remove(5);
+  checkTest("testIndexedSeek #7", 4, d.get(5));
+  d.remove(0);
+  checkTest("testIndexedSeek #8", 4, d.get(4));
+  d.insert(19, 99);
+  checkTest("testIndexedSeek #9", "0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 99 19", d.getListAsString());
+  checkTest("testIndexedSeek #10", "19 99 18 17 16 15 14 13 12 11 10 9 8 7 6 5 4 3 2 1 0", d.getListBackwardsAsString());
+  d.remove(20);
+  checkTest("testIndexedSeek #11", 99, d.get(19));
+  d[19] = 19;
+  checkTest("testIndexedSeek #12", 20, d.size());
+  d.removeAllInstances(19);
+  checkTest("testIndexedSeek #13", 18, d.get(18));
+  checkTest("testIndexedSeek #14", 19, d.size());
+}
+
+// The original get(), which always walks forward from first.
+template <typename T>
+class ForwardWalkDoublyLinkedList : public DoublyLinkedList<T> {
+public:
+  T getWalkingFromFirst(const unsigned int index) const {
+    Node<T>* currentNode = this->first;
+    unsigned int position = 0;
+    while (currentNode->forward != nullptr) {
+      if (position == index) {
+        break;
+      }
+      currentNode = currentNode->forward;
+      position++;
+    }
+    if (position < index) {
+      throw 1;
+    }
+    return currentNode->data;
+  }
+};
+
+void benchmarkIndexedSeek() {
+  const unsigned int listSize = 100000;
+  const unsigned int walkedSize = 10000;
+  ForwardWalkDoublyLinkedList<int> d;
+  for (unsigned int i = 0; i < listSize; i++) {
+    d.insertLast(i);
+  }
+  long long total = 0;
+  cout << "Benchmarking indexed access on a 100,000 item list." << endl;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < walkedSize; i++) {
+    total += d.getWalkingFromFirst(i);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  cout << "    Walking from first for each of the first 10,000 indexes took " << (diff.count() / 1000.0) << " milliseconds." << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < listSize; i++) {
+    total += d.get(i);
+  }
+  for (unsigned int i = listSize; i > 0; i--) {
+    total += d[i - 1];
+  }
+  end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  cout << "    Seeking every index forwards and then backwards took " << (diff.count() / 1000.0) << " milliseconds." << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < 1000; i++) {
+    total += d.get((i * 7919u) % listSize);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  cout << "    Seeking 1,000 scattered indexes took " << (diff.count() / 1000.0) << " milliseconds (checksum " << total << ")." << endl;
+}
+
+void testRemoveIf() {
+  DoublyLinkedList<int>* d = new DoublyLinkedList<int>;
+  std::size_t emptyList = ManageMemory::getTotalSize();
+  for (int i = 0; i < 20; i++) {
+    d->insertLast(i % 5 < 2 ? 0 : i);
+  }
+  checkTest("testRemoveIf #1", "0 0 2 3 4 0 0 7 8 9 0 0 12 13 14 0 0 17 18 19", d->getListAsString());
+  checkTest("testRemoveIf #2", 8, d->remove_if([](int data) { return data == 0; }));
+  checkTest("testRemoveIf #3", "2 3 4 7 8 9 12 13 14 17 18 19", d->getListAsString());
+  checkTest("testRemoveIf #4", "19 18 17 14 13 12 9 8 7 4 3 2", d->getListBackwardsAsString());
+  checkTest("testRemoveIf #5", 12, d->size());
+  checkTest("testRemoveIf #6", 6, d->remove_if([](int data) { return data % 2 == 1; }));
+  checkTest("testRemoveIf #7", "2 4 8 12 14 18", d->getListAsString());
+  checkTest("testRemoveIf #8", 0, d->remove_if([](int data) { return data > 100; }));
+  checkTest("testRemoveIf #9", 8, d->get(2));
+
+  // Inserting again reuses the removed nodes instead of allocating.
+  std::size_t before = ManageMemory::getTotalSize();
+  for (int i = 0; i < 14; i++) {
+    d->insertFirst(i);
+  }
+  checkTest("testRemoveIf #10", (int)before, (int)ManageMemory::getTotalSize());
+  checkTest("testRemoveIf #11", 20, d->remove_if([](int) { return true; }));
+  checkTest("testRemoveIf #12", "The list is empty.", d->getListAsString());
+  checkTest("testRemoveIf #13", "The list is empty.", d->getListBackwardsAsString());
+  d->releaseSpareNodes();
+  checkTest("testRemoveIf #14", (int)emptyList, (int)ManageMemory::getTotalSize());
+  d->insertLast(5);
+  checkTest("testRemoveIf #15", "5", d->getListBackwardsAsString());
+  delete d;
+
+  // Removed items are let go of right away, not when their node is reused.
+  DoublyLinkedList<std::shared_ptr<int>> shared;
+  std::shared_ptr<int> item = std::make_shared<int>(7);
+  shared.insertLast(item);
+  shared.insertLast(item);
+  checkTest("testRemoveIf #16", 3, (int)item.use_count());
+  shared.remove(0);
+  checkTest("testRemoveIf #17", 2, (int)item.use_count());
+  shared.remove_if([](const std::shared_ptr<int>&) { return true; });
+  checkTest("testRemoveIf #18", 1, (int)item.use_count());
+
+  // Only maxSpareNodes removed nodes are kept, the rest are given back.
+  d = new DoublyLinkedList<int>;
+  emptyList = ManageMemory::getTotalSize();
+  for (int i = 0; i < 1000; i++) {
+    d->insertLast(i);
+  }
+  d->remove_if([](int) { return true; });
+  checkTest("testRemoveIf #19", (int)(emptyList + DoublyLinkedList<int>::maxSpareNodes * sizeof(Node<int>)), (int)ManageMemory::getTotalSize());
+  delete d;
+}
+
+// The map based tracker ManageMemory used to be, kept to benchmark against.
+class MapTrackedMemory {
+public:
+  static std::size_t getTotalSize() {
+    std::size_t total = 0;
+    std::map<void*, std::size_t>::iterator iter;
+    for (iter = mapOfAllocations.begin(); iter != mapOfAllocations.end(); ++iter) {
+      total += iter->second;
+    }
+    return total;
+  }
+  void* operator new(std::size_t x) {
+    void* ptr = ::operator new(x);
+    mapOfAllocations[ptr] = x;
+    return ptr;
+  }
+  void operator delete(void* x) {
+    mapOfAllocations.erase(x);
+    ::operator delete(x);
+  }
+
+private:
+  static std::map<void*, std::size_t> mapOfAllocations;
+};
+std::map<void*, std::size_t> MapTrackedMemory::mapOfAllocations;
+
+class MapTrackedNode : public MapTrackedMemory {
+public:
+  int data{};
+  MapTrackedNode* backward{ nullptr };
+  MapTrackedNode* forward{ nullptr };
+};
+
+void testManageMemory() {
+  checkTest("testManageMemory #1", 0, ManageMemory::sizeClassOf(1));
+  checkTest("testManageMemory #2", 1, ManageMemory::sizeClassOf(2));
+  checkTest("testManageMemory #3", 2, ManageMemory::sizeClassOf(3));
+  checkTest("testManageMemory #4", 5, ManageMemory::sizeClassOf(32));
+  checkTest("testManageMemory #5", 6, ManageMemory::sizeClassOf(33));
+
+  std::size_t bytes = ManageMemory::getTotalSize();
+  std::size_t allocations = ManageMemory::getAllocationCount();
+  Node<int>* node = new Node<int>();
+  checkTest("testManageMemory #6", (int)(bytes + sizeof(Node<int>)), (int)ManageMemory::getTotalSize());
+  checkTest("testManageMemory #7", (int)(allocations + 1), (int)ManageMemory::getAllocationCount());
+  Node<int>* nodes = new Node<int>[3];
+  checkTest("testManageMemory #8", (int)(allocations + 2), (int)ManageMemory::getAllocationCount());
+  checkTest("testManageMemory #9", true, ManageMemory::getTotalSize() >= bytes + 4 * sizeof(Node<int>));
+  delete[] nodes;
+  delete node;
+  checkTest("testManageMemory #10", (int)bytes, (int)ManageMemory::getTotalSize());
+  checkTest("testManageMemory #11", (int)allocations, (int)ManageMemory::getAllocationCount());
+
+  // Only what was allocated while the histogram was on shows up in it.
+  const unsigned int nodeClass = ManageMemory::sizeClassOf(sizeof(Node<int>));
+  Node<int>* untracked = new Node<int>();
+  ManageMemory::setHistogramEnabled(true);
+  Node<int>* first = new Node<int>();
+  Node<int>* second = new Node<int>();
+  checkTest("testManageMemory #12", 2, (int)ManageMemory::getSizeClassCount(nodeClass));
+  delete untracked;
+  delete first;
+  checkTest("testManageMemory #13", 1, (int)ManageMemory::getSizeClassCount(nodeClass));
+  ManageMemory::setHistogramEnabled(false);
+  delete second;
+  checkTest("testManageMemory #14", 0, (int)ManageMemory::getSizeClassCount(nodeClass));
+  checkTest("testManageMemory #15", 0, (int)ManageMemory::getSizeClassCount(1000));
+}
+
+void benchmarkManageMemory() {
+  const unsigned int nodeCount = 200000;
+  std::vector<MapTrackedNode*> mapNodes(nodeCount);
+  std::vector<Node<int>*> nodes(nodeCount);
+  cout << "Benchmarking allocating and freeing 200,000 tracked nodes, asking for the total halfway." << endl;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    mapNodes[i] = new MapTrackedNode();
+  }
+  std::size_t total = MapTrackedMemory::getTotalSize();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    delete mapNodes[i];
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  cout << "    The map tracker took " << (diff.count() / 1000.0) << " milliseconds (" << total << " bytes)." << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    nodes[i] = new Node<int>();
+  }
+  total = ManageMemory::getTotalSize();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    delete nodes[i];
+  }
+  end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  cout << "    The counters took " << (diff.count() / 1000.0) << " milliseconds (" << total << " bytes)." << endl;
+
+  ManageMemory::setHistogramEnabled(true);
+  start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    nodes[i] = new Node<int>();
+  }
+  total = ManageMemory::getTotalSize();
+  for (unsigned int i = 0; i < nodeCount; i++) {
+    delete nodes[i];
+  }
+  end = std::chrono::high_resolution_clock::now();
+  ManageMemory::setHistogramEnabled(false);
+  diff = end - start;
+  cout << "    The counters with the histogram took " << (diff.count() / 1000.0) << " milliseconds (" << total << " bytes)." << endl;
+}
+
+// One shared counter for every thread, which is what ManageMemory kept before it was sharded.
+class GlobalCounterMemory {
+public:
+  static std::size_t getTotalSize() { return totalBytes.load(std::memory_order_relaxed); }
+  void* operator new(std::size_t x) {
+    void* block = ::operator new(x + alignof(std::max_align_t));
+    *static_cast<std::size_t*>(block) = x;
+    totalBytes.fetch_add(x, std::memory_order_relaxed);
+    return static_cast<char*>(block) + alignof(std::max_align_t);
+  }
+  void operator delete(void* x) {
+    void* block = static_cast<char*>(x) - alignof(std::max_align_t);
+    totalBytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+    ::operator delete(block);
+  }
+
+private:
+  static std::atomic<std::size_t> totalBytes;
+};
+std::atomic<std::size_t> GlobalCounterMemory::totalBytes{ 0 };
+
+class GlobalCounterNode : public GlobalCounterMemory {
+public:
+  int data{};
+  GlobalCounterNode* backward{ nullptr };
+  GlobalCounterNode* forward{ nullptr };
+};
+
+void testMemoryAccounting() {
+  const MemorySnapshot before = ManageMemory::snapshot();
+  const unsigned int threadCount = 4;
+  const unsigned int listSize = 5000;
+  std::vector<DoublyLinkedList<int>*> lists(threadCount);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.emplace_back([&lists, i, listSize]() {
+      lists[i] = new DoublyLinkedList<int>;
+      for (unsigned int j = 0; j < listSize; j++) {
+        lists[i]->insertLast(j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const std::size_t nodeBytes = threadCount * listSize * sizeof(Node<int>);
+  const std::size_t listBytes = threadCount * sizeof(DoublyLinkedList<int>);
+  checkTest("testMemoryAccounting #1", (int)(before.liveBytes + nodeBytes + listBytes), (int)ManageMemory::getTotalSize());
+  checkTest("testMemoryAccounting #2", (int)(before.liveAllocations + threadCount * (listSize + 1)), (int)ManageMemory::getAllocationCount());
+
+  // Free the lists on other threads than the ones that built them.
+  threads.clear();
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.emplace_back([&lists, i, threadCount]() { delete lists[(i + 1) % threadCount]; });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const MemorySnapshot after = ManageMemory::snapshot();
+  const MemorySnapshot change = after.diff(before);
+  checkTest("testMemoryAccounting #3", 0, (int)change.liveBytes);
+  checkTest("testMemoryAccounting #4", 0, (int)change.liveAllocations);
+  checkTest("testMemoryAccounting #5", (int)(threadCount * (listSize + 1)), (int)change.allocations);
+  checkTest("testMemoryAccounting #6", true, after.peakBytes + threadCount * ManageMemory::peakGranularity >= nodeBytes + listBytes);
+  checkTest("testMemoryAccounting #7", true, after.peakBytes <= before.peakBytes + nodeBytes + listBytes);
+  checkTest("testMemoryAccounting #8", 2, (int)change.allocationSizes.size());
+  checkTest("testMemoryAccounting #9", (int)sizeof(Node<int>), (int)change.allocationSizes[0].first);
+  checkTest("testMemoryAccounting #10", (int)(threadCount * listSize), (int)change.allocationSizes[0].second);
+  checkTest("testMemoryAccounting #11", (int)sizeof(DoublyLinkedList<int>), (int)change.allocationSizes[1].first);
+
+  std::vector<std::pair<std::size_t, long long>> top = ManageMemory::getTopAllocationSizes(1);
+  checkTest("testMemoryAccounting #12", 1, (int)top.size());
+  checkTest("testMemoryAccounting #13", (int)sizeof(Node<int>), (int)top[0].first);
+
+  // A thread_local made before the thread's first allocation is destroyed after the thread has
+  // given its shard back, and what it frees then still has to be counted.
+  struct FreedAtThreadExit {
+    DoublyLinkedList<int>* list{ nullptr };
+    ~FreedAtThreadExit() { delete list; }
+  };
+  const MemorySnapshot beforeExit = ManageMemory::snapshot();
+  threads.clear();
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.emplace_back([listSize]() {
+      thread_local FreedAtThreadExit holder;
+      holder.list = new DoublyLinkedList<int>;
+      for (unsigned int j = 0; j < listSize; j++) {
+        holder.list->insertLast(j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const MemorySnapshot afterExit = ManageMemory::snapshot().diff(beforeExit);
+  checkTest("testMemoryAccounting #14", 0, (int)afterExit.liveBytes);
+  checkTest("testMemoryAccounting #15", 0, (int)afterExit.liveAllocations);
+}
+
+template <typename TrackedNode>
+double measureTrackedAllocations(const unsigned int threadCount, const unsigned int nodesPerThread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.emplace_back([nodesPerThread]() {
+      std::vector<TrackedNode*> nodes(1000);
+      for (unsigned int done = 0; done < nodesPerThread; done += 1000) {
+        for (TrackedNode*& node : nodes) {
+          node = new TrackedNode();
+        }
+        for (TrackedNode* node : nodes) {
+          delete node;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return diff.count() / 1000.0;
+}
+
+void benchmarkMemoryAccounting() {
+  const unsigned int nodes = 800000;
+  cout << "Benchmarking 800,000 tracked node allocations and frees split over threads, in milliseconds ("
+       << std::thread::hardware_concurrency() << " hardware threads)." << endl;
+  for (unsigned int threadCount = 1; threadCount <= 8; threadCount *= 2) {
+    double global = measureTrackedAllocations<GlobalCounterNode>(threadCount, nodes / threadCount);
+    double sharded = measureTrackedAllocations<Node<int>>(threadCount, nodes / threadCount);
+    cout << "    " << threadCount << " thread" << (threadCount == 1 ? ":  " : "s: ") << "one shared counter " << global
+         << ", sharded counters " << sharded << endl;
+  }
+}
+
+void testIterators() {
+  DoublyLinkedList<int> d;
+  for (int i = 1; i <= 6; i++) {
+    d.insertLast(i * 10);
+  }
+  int sum = 0;
+  for (int item : d) {
+    sum += item;
+  }
+  checkTest("testIterators #1", 210, sum);
+  std::vector<int> backwards(d.rbegin(), d.rend());
+  checkTest("testIterators #2", 60, backwards[0]);
+  checkTest("testIterators #3", 10, backwards[5]);
+  checkTest("testIterators #4", 60, *--d.end());
+  checkTest("testIterators #5", 3, (int)std::distance(d.begin(), std::find(d.begin(), d.end(), 40)));
+  checkTest("testIterators #6", 2, (int)std::count_if(d.cbegin(), d.cend(), [](int item) { return item > 40; }));
+
+  // Writing through an iterator, and through a const list's const_iterator.
+  for (DoublyLinkedList<int>::iterator it = d.begin(); it != d.end(); ++it) {
+    *it += 1;
+  }
+  const DoublyLinkedList<int>& constList = d;
+  DoublyLinkedList<int>::const_iterator constIt = constList.begin();
+  checkTest("testIterators #7", 11, *constIt);
+  checkTest("testIterators #8", 61, *constList.crbegin());
+
+  DoublyLinkedList<int>::iterator it = d.insert(std::find(d.begin(), d.end(), 31), 25);
+  checkTest("testIterators #9", 25, *it);
+  d.insert(d.end(), 70);
+  d.insert(d.begin(), 5);
+  checkTest("testIterators #10", "5 11 21 25 31 41 51 61 70", d.getListAsString());
+  checkTest("testIterators #11", 9, d.size());
+  checkTest("testIterators #12", 31, d.get(4));
+
+  // Erase every odd item while walking the list.
+  for (it = d.begin(); it != d.end();) {
+    it = *it % 2 == 1 ? d.erase(it) : std::next(it);
+  }
+  checkTest("testIterators #13", "70", d.getListBackwardsAsString());
+  checkTest("testIterators #14", "70", d.getListAsString());
+  checkTest("testIterators #15", 1, d.size());
+
+  DoublyLinkedList<int> other;
+  for (int i = 1; i <= 5; i++) {
+    other.insertLast(i);
+  }
+  d.splice(d.begin(), other, std::next(other.begin()), std::prev(other.end()));
+  checkTest("testIterators #16", "2 3 4 70", d.getListAsString());
+  checkTest("testIterators #17", "5 1", other.getListBackwardsAsString());
+  checkTest("testIterators #18", 2, other.size());
+  d.splice(d.end(), other);
+  checkTest("testIterators #19", "2 3 4 70 1 5", d.getListAsString());
+  checkTest("testIterators #20", "5 1 70 4 3 2", d.getListBackwardsAsString());
+  checkTest("testIterators #21", 6, d.size());
+  checkTest("testIterators #22", "The list is empty.", other.getListAsString());
+  checkTest("testIterators #23", 0, other.size());
+  checkTest("testIterators #24", true, other.begin() == other.end());
+  checkTest("testIterators #25", 70, d[3]);
+}
+
+void benchmarkIterators() {
+  const unsigned int listSize = 1000000;
+  DoublyLinkedList<int> d;
+  for (unsigned int i = 0; i < listSize; i++) {
+    d.insertLast(i % 1000);
+  }
+  long long total = 0;
+  cout << "Benchmarking summing a 1,000,000 item list." << endl;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int i = 0; i < listSize; i++) {
+    total += d.get(i);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  cout << "    By index with get() took " << (diff.count() / 1000.0) << " milliseconds." << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int item : d) {
+    total += item;
+  }
+  end = std::chrono::high_resolution_clock::now();
+  diff = end - start;
+  cout << "    With iterators took " << (diff.count() / 1000.0) << " milliseconds (checksum " << total << ")." << endl;
+}
+
+void testArenaDoublyLinkedList() {
+  ArenaDoublyLinkedList<int> d;
+  checkTest("testArenaDoublyLinkedList #1", "The list is empty.", d.getListAsString());
+  for (int i = 0; i < 10; i++) {
+    d.insertLast(i);
+  }
+  d.insertFirst(-1);
+  d.insert(5, 100);
+  checkTest("testArenaDoublyLinkedList #2", "-1 0 1 2 3 100 4 5 6 7 8 9", d.getListAsString());
+  checkTest("testArenaDoublyLinkedList #3", "9 8 7 6 5 4 100 3 2 1 0 -1", d.getListBackwardsAsString());
+  checkTest("testArenaDoublyLinkedList #4", 100, d.get(5));
+  d[6] = 44;
+  checkTest("testArenaDoublyLinkedList #5", 44, d.get(6));
+  try {
+    d.get(12);
+    checkTest("testArenaDoublyLinkedList #6", "an error", "no error");
+  } catch (...) {
+    checkTest("testArenaDoublyLinkedList #6", "an error", "an error");
+  }
+
+  d.remove(0);
+  d.remove(10);
+  checkTest("testArenaDoublyLinkedList #7", "0 1 2 3 100 44 5 6 7 8", d.getListAsString());
+  checkTest("testArenaDoublyLinkedList #8", 4, d.remove_if([](int item) { return item % 2 == 1; }));
+  checkTest("testArenaDoublyLinkedList #9", "0 2 100 44 6 8", d.getListAsString());
+  checkTest("testArenaDoublyLinkedList #10", 6, d.size());
+
+  // Removed slots are filled again before the vector grows.
+  checkTest("testArenaDoublyLinkedList #11", 12, d.getSlotCount());
+  for (int i = 0; i < 6; i++) {
+    d.insert(2, 50 + i);
+  }
+  checkTest("testArenaDoublyLinkedList #12", 12, d.getSlotCount());
+  checkTest("testArenaDoublyLinkedList #13", "0 2 55 54 53 52 51 50 100 44 6 8", d.getListAsString());
+
+  int sum = 0;
+  for (int item : d) {
+    sum += item;
+  }
+  checkTest("testArenaDoublyLinkedList #14", 475, sum);
+  checkTest("testArenaDoublyLinkedList #15", 8, *d.rbegin());
+  ArenaDoublyLinkedList<int>::iterator it = d.erase(std::find(d.begin(), d.end(), 100));
+  checkTest("testArenaDoublyLinkedList #16", 44, *it);
+  d.insert(it, 99);
+  d.removeAllInstances(2);
+  checkTest("testArenaDoublyLinkedList #17", "0 55 54 53 52 51 50 99 44 6 8", d.getListAsString());
+
+  d.compact();
+  checkTest("testArenaDoublyLinkedList #18", 11, d.getSlotCount());
+  checkTest("testArenaDoublyLinkedList #19", "0 55 54 53 52 51 50 99 44 6 8", d.getListAsString());
+  checkTest("testArenaDoublyLinkedList #20", "8 6 44 99 50 51 52 53 54 55 0", d.getListBackwardsAsString());
+  checkTest("testArenaDoublyLinkedList #21", 99, d[7]);
+  d.insertFirst(7);
+  checkTest("testArenaDoublyLinkedList #22", 7, d.get(0));
+  checkTest("testArenaDoublyLinkedList #23", 8, *--d.end());
+
+  ArenaDoublyLinkedList<string> s;
+  s.insertLast("b");
+  s.insertFirst("a");
+  s.insertLast("c");
+  s.remove(1);
+  s.compact();
+  checkTest("testArenaDoublyLinkedList #24", "a c", s.getListAsString());
+  s.remove_if([](const string&) { return true; });
+  s.compact();
+  checkTest("testArenaDoublyLinkedList #25", "The list is empty.", s.getListAsString());
+  checkTest("testArenaDoublyLinkedList #26", 0, s.getSlotCount());
+}
+
+// Builds the same list in both kinds, with enough removes and inserts in the middle that
+// neighboring items no longer sit next to each other in memory.
+template <typename List>
+void buildScatteredList(List& list, const unsigned int listSize) {
+  for (unsigned int i = 0; i < listSize; i++) {
+    list.insertLast(i % 1000);
+  }
+  // Drop every third item, then put as many back in between the others from the back forwards,
+  // so each new item lands far from its neighbors in memory.
+  unsigned int position = 0;
+  for (typename List::iterator it = list.begin(); it != list.end(); position++) {
+    it = position % 3 == 0 ? list.erase(it) : std::next(it);
+  }
+  typename List::iterator it = list.end();
+  for (unsigned int i = 0; list.size() < listSize; i++) {
+    it = list.insert(std::prev(it, 2), i % 1000);
+  }
+}
+
+template <typename List>
+double measureListScan(const List& list, long long& total) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int repeat = 0; repeat < 10; repeat++) {
+    for (int item : list) {
+      total += item;
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return diff.count() / 1000.0;
+}
+
+void benchmarkArenaDoublyLinkedList() {
+  const unsigned int listSize = 1000000;
+  long long total = 0;
+  cout << "Benchmarking walking a 1,000,000 item list 10 times, after scattering it with removes and inserts." << endl;
+  {
+    DoublyLinkedList<int> d;
+    buildScatteredList(d, listSize);
+    cout << "    DoublyLinkedList took " << measureListScan(d, total) << " milliseconds." << endl;
+  }
+  ArenaDoublyLinkedList<int> arena;
+  buildScatteredList(arena, listSize);
+  cout << "    ArenaDoublyLinkedList took " << measureListScan(arena, total) << " milliseconds." << endl;
+  arena.compact();
+  double compacted = measureListScan(arena, total);
+  cout << "    ArenaDoublyLinkedList after compact() took " << compacted << " milliseconds (checksum " << total << ")." << endl;
+}
+
 void pressAnyKeyToContinue() {
   cout << "Press enter to continue...";
   cin.get();
@@ -752,5 +2444,32 @@ int main() {
   testRemoveAllInstances();
   checkTestMemory("Memory Leak/Allocation Test #6", 0, ManageMemory::getTotalSize());
   pressAnyKeyToContinue();
+  testWriteList();
+  benchmarkWriteList();
+  checkTestMemory("Memory Leak/Allocation Test #7", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testIndexedSeek();
+  benchmarkIndexedSeek();
+  checkTestMemory("Memory Leak/Allocation Test #8", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testRemoveIf();
+  checkTestMemory("Memory Leak/Allocation Test #9", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testManageMemory();
+  benchmarkManageMemory();
+  checkTestMemory("Memory Leak/Allocation Test #10", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testMemoryAccounting();
+  benchmarkMemoryAccounting();
+  checkTestMemory("Memory Leak/Allocation Test #11", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testIterators();
+  benchmarkIterators();
+  checkTestMemory("Memory Leak/Allocation Test #12", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
+  testArenaDoublyLinkedList();
+  benchmarkArenaDoublyLinkedList();
+  checkTestMemory("Memory Leak/Allocation Test #13", 0, ManageMemory::getTotalSize());
+  pressAnyKeyToContinue();
   return 0;
 }
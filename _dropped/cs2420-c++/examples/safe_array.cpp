@@ -1,50 +1,873 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 
+using std::cerr;
 using std::cin;
 using std::cout;
 using std::endl;
 
+// What a SafeArray does with an index that is out of bounds is picked at compile time by its
+// CheckPolicy.  A policy says whether indexes get checked at all, and what to do with a bad one.
+// If outOfBounds() returns, the access is skipped: writes are dropped and reads give T{}.
+// sizeMismatch() is the same for two arrays that should be the same size and aren't; if it
+// returns, only the items both arrays have are used.
+struct ThrowOnOutOfBounds {
+  static constexpr bool checks = true;
+  static void outOfBounds(const unsigned int) { throw std::out_of_range("Index is out of bounds"); }
+  static void sizeMismatch(const unsigned int, const unsigned int) {
+    throw std::invalid_argument("The arrays are different sizes");
+  }
+};
+
+struct AbortOnOutOfBounds {
+  static constexpr bool checks = true;
+  static void outOfBounds(const unsigned int index) {
+    cerr << "Index " << index << " is out of bounds" << endl;
+    std::abort();
+  }
+  static void sizeMismatch(const unsigned int size, const unsigned int otherSize) {
+    cerr << "An array of " << size << " items was used with one of " << otherSize << endl;
+    std::abort();
+  }
+};
+
+// Says so the first time, and quietly skips every bad access after that.
+struct LogOnceOnOutOfBounds {
+  static constexpr bool checks = true;
+  static void outOfBounds(const unsigned int) {
+    static bool logged = false;
+    if (!logged) {
+      logged = true;
+      cout << "Index is out of bounds" << endl;
+    }
+  }
+  static void sizeMismatch(const unsigned int, const unsigned int) {
+    static bool logged = false;
+    if (!logged) {
+      logged = true;
+      cout << "The arrays are different sizes" << endl;
+    }
+  }
+};
+
+// No checks, so indexing compiles down to the same code as indexing a plain array.
+struct Unchecked {
+  static constexpr bool checks = false;
+  static void outOfBounds(const unsigned int) {}
+  static void sizeMismatch(const unsigned int, const unsigned int) {}
+};
+
+//******************
+// Bulk kernels over a buffer, for SafeArray's fill, iota, sum, minmax, scale, axpy, count_if and find.
+// The same loops are compiled once per instruction set with GCC's vector extensions, and
+// bulkKernelTable() uses the widest set the CPU has unless setSimdLevel() says otherwise.
+//******************
+enum class SimdLevel { SCALAR, SSE2, AVX2, AVX512 };
+enum class Comparison { LESS, LESS_EQUAL, EQUAL, NOT_EQUAL, GREATER_EQUAL, GREATER };
+
+// Vector code has to be inlined into the entry point for its instruction set to be compiled for it.
+#ifdef __GNUC__
+#define SAFE_ARRAY_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define SAFE_ARRAY_ALWAYS_INLINE inline
+#endif
+
+// Sets result to a C b; a and b can be vectors too, which is why the result isn't returned (see
+// VectorKernels::at).
+template <Comparison C, typename A, typename R>
+SAFE_ARRAY_ALWAYS_INLINE void compareWith(const A& a, const A& b, R& result) {
+  if constexpr (C == Comparison::LESS) {
+    result = a < b;
+  } else if constexpr (C == Comparison::LESS_EQUAL) {
+    result = a <= b;
+  } else if constexpr (C == Comparison::EQUAL) {
+    result = a == b;
+  } else if constexpr (C == Comparison::NOT_EQUAL) {
+    result = a != b;
+  } else if constexpr (C == Comparison::GREATER_EQUAL) {
+    result = a >= b;
+  } else {
+    result = a > b;
+  }
+}
+
+// One item at a time, for any T and any compiler.
+template <typename T>
+struct ScalarKernels {
+  static void fill(T* data, const std::size_t n, const T value) {
+    for (std::size_t i = 0; i < n; i++) {
+      data[i] = value;
+    }
+  }
+  // Arithmetic types get value + T(i) rather than counting up one at a time, which is what the
+  // vector kernels compute too, so every level agrees even where a float can no longer count by
+  // ones (past 2^24); integers wrap around instead of overflowing.
+  static T iotaAt(const T value, const std::size_t i) {
+    if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value) {
+      typedef typename std::make_unsigned<T>::type Unsigned;
+      return static_cast<T>(static_cast<Unsigned>(static_cast<Unsigned>(value) + static_cast<Unsigned>(i)));
+    } else {
+      return value + static_cast<T>(i);
+    }
+  }
+  static void iota(T* data, const std::size_t n, T value) {
+    if constexpr (std::is_arithmetic<T>::value) {
+      for (std::size_t i = 0; i < n; i++) {
+        data[i] = iotaAt(value, i);
+      }
+    } else {
+      for (std::size_t i = 0; i < n; i++) {
+        data[i] = value++;
+      }
+    }
+  }
+  static T sum(const T* data, const std::size_t n) {
+    T total{};
+    for (std::size_t i = 0; i < n; i++) {
+      total += data[i];
+    }
+    return total;
+  }
+  // n has to be at least 1.
+  static void minmax(const T* data, const std::size_t n, T& low, T& high) {
+    low = data[0];
+    high = data[0];
+    for (std::size_t i = 1; i < n; i++) {
+      low = data[i] < low ? data[i] : low;
+      high = high < data[i] ? data[i] : high;
+    }
+  }
+  static void scale(T* data, const std::size_t n, const T factor) {
+    for (std::size_t i = 0; i < n; i++) {
+      data[i] *= factor;
+    }
+  }
+  static void axpy(T* y, const T* x, const std::size_t n, const T a) {
+    for (std::size_t i = 0; i < n; i++) {
+      y[i] += a * x[i];
+    }
+  }
+  template <Comparison C>
+  static std::size_t countIf(const T* data, const std::size_t n, const T value) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      bool hit;
+      compareWith<C>(data[i], value, hit);
+      count += hit ? 1 : 0;
+    }
+    return count;
+  }
+  static std::size_t find(const T* data, const std::size_t n, const T value) {
+    for (std::size_t i = 0; i < n; i++) {
+      if (data[i] == value) {
+        return i;
+      }
+    }
+    return n;
+  }
+};
+
+// Types GCC can put in a vector.
+template <typename T>
+constexpr bool hasVectorKernels = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, long double>::value;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAFE_ARRAY_SIMD 1
+
+// The integer type iota counts in for T, as wide as T so its vectors have as many lanes: T's own
+// bits for integers, and a signed integer for floating point, which converts in one instruction.
+template <typename T, bool Integral = std::is_integral<T>::value>
+struct IotaIndex {
+  typedef typename std::make_unsigned<T>::type type;
+};
+template <typename T>
+struct IotaIndex<T, false> {
+  typedef typename std::conditional<sizeof(T) == 4, std::int32_t, std::int64_t>::type type;
+};
+
+// The same loops a vector of Bytes bytes at a time, with ScalarKernels finishing what's left over.
+template <typename T, int Bytes>
+struct VectorKernels {
+  typedef T Vector __attribute__((vector_size(Bytes)));
+  static const std::size_t lanes = Bytes / sizeof(T);
+
+  // The same vector at any address a T can be at, read and written in place through at().
+  // Vectors only ever go in and out of these helpers by reference, since passing or returning one
+  // by value outside a function compiled for its instruction set changes the ABI.
+  typedef T UnalignedVector __attribute__((vector_size(Bytes), aligned(alignof(T)), may_alias));
+  SAFE_ARRAY_ALWAYS_INLINE static const UnalignedVector& at(const T* data) {
+    return *reinterpret_cast<const UnalignedVector*>(data);
+  }
+  SAFE_ARRAY_ALWAYS_INLINE static UnalignedVector& at(T* data) { return *reinterpret_cast<UnalignedVector*>(data); }
+
+  SAFE_ARRAY_ALWAYS_INLINE static void fill(T* data, const std::size_t n, const T value) {
+    const Vector values = Vector{} + value;
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      at(data + i) = values;
+    }
+    ScalarKernels<T>::fill(data + i, n - i, value);
+  }
+  // The index counts in an integer vector and is converted at every step, so this is value + T(i)
+  // exactly like ScalarKernels::iota, rather than a running float total that drifts from it.
+  SAFE_ARRAY_ALWAYS_INLINE static void iota(T* data, const std::size_t n, const T value) {
+    typedef typename IotaIndex<T>::type Index;
+    typedef Index Indices __attribute__((vector_size(Bytes)));
+    if (!std::is_integral<T>::value && n > static_cast<std::size_t>(std::numeric_limits<Index>::max())) {
+      ScalarKernels<T>::iota(data, n, value);
+      return;
+    }
+    Indices indices;
+    for (std::size_t lane = 0; lane < lanes; lane++) {
+      indices[lane] = static_cast<Index>(lane);
+    }
+    const Vector base = Vector{} + value;
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      at(data + i) = base + __builtin_convertvector(indices, Vector);
+      indices += static_cast<Index>(lanes);
+    }
+    for (; i < n; i++) {
+      data[i] = ScalarKernels<T>::iotaAt(value, i);
+    }
+  }
+  // Adds in a different order than a plain loop, so float sums can differ in the last bits.
+  SAFE_ARRAY_ALWAYS_INLINE static T sum(const T* data, const std::size_t n) {
+    Vector totals{};
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      totals += at(data + i);
+    }
+    T total = ScalarKernels<T>::sum(data + i, n - i);
+    for (std::size_t lane = 0; lane < lanes; lane++) {
+      total += totals[lane];
+    }
+    return total;
+  }
+  SAFE_ARRAY_ALWAYS_INLINE static void minmax(const T* data, const std::size_t n, T& low, T& high) {
+    if (n < lanes) {
+      ScalarKernels<T>::minmax(data, n, low, high);
+      return;
+    }
+    Vector lows = at(data);
+    Vector highs = lows;
+    std::size_t i = lanes;
+    for (; i + lanes <= n; i += lanes) {
+      const Vector values = at(data + i);
+      lows = values < lows ? values : lows;
+      highs = highs < values ? values : highs;
+    }
+    // The last few overlap what's already been seen, which doesn't change a min or max.
+    const Vector values = at(data + n - lanes);
+    lows = values < lows ? values : lows;
+    highs = highs < values ? values : highs;
+    ScalarKernels<T>::minmax(reinterpret_cast<const T*>(&lows), lanes, low, high);
+    T ignored;
+    ScalarKernels<T>::minmax(reinterpret_cast<const T*>(&highs), lanes, ignored, high);
+  }
+  SAFE_ARRAY_ALWAYS_INLINE static void scale(T* data, const std::size_t n, const T factor) {
+    const Vector factors = Vector{} + factor;
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      at(data + i) = at(data + i) * factors;
+    }
+    ScalarKernels<T>::scale(data + i, n - i, factor);
+  }
+  SAFE_ARRAY_ALWAYS_INLINE static void axpy(T* y, const T* x, const std::size_t n, const T a) {
+    const Vector as = Vector{} + a;
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      at(y + i) = at(y + i) + as * at(x + i);
+    }
+    ScalarKernels<T>::axpy(y + i, x + i, n - i, a);
+  }
+  // A true comparison is -1 in every bit of its lane, so subtracting the results counts them.
+  // The lane counters are emptied often enough that they can't overflow, even for char.
+  template <Comparison C>
+  SAFE_ARRAY_ALWAYS_INLINE static std::size_t countIf(const T* data, const std::size_t n, const T value) {
+    typedef decltype(Vector{} < Vector{}) Mask;
+    const Vector values = Vector{} + value;
+    const std::size_t blockSize = lanes * 127;
+    std::size_t count = 0;
+    std::size_t i = 0;
+    while (i + lanes <= n) {
+      Mask counts{};
+      const std::size_t blockEnd = n - i > blockSize ? i + blockSize : n;
+      for (; i + lanes <= blockEnd; i += lanes) {
+        Mask hits;
+        compareWith<C>(at(data + i), values, hits);
+        counts -= hits;
+      }
+      for (std::size_t lane = 0; lane < lanes; lane++) {
+        count += static_cast<std::size_t>(counts[lane]);
+      }
+    }
+    return count + ScalarKernels<T>::template countIf<C>(data + i, n - i, value);
+  }
+  SAFE_ARRAY_ALWAYS_INLINE static std::size_t find(const T* data, const std::size_t n, const T value) {
+    typedef decltype(Vector{} == Vector{}) Mask;
+    const Vector values = Vector{} + value;
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      const Mask hits = at(data + i) == values;
+      unsigned long long words[sizeof(Mask) / sizeof(unsigned long long)];
+      std::memcpy(words, &hits, sizeof(hits));
+      unsigned long long any = 0;
+      for (unsigned long long word : words) {
+        any |= word;
+      }
+      if (any) {
+        return i + ScalarKernels<T>::find(data + i, lanes, value);
+      }
+    }
+    return i + ScalarKernels<T>::find(data + i, n - i, value);
+  }
+};
+
+// Entry points compiled for one instruction set, which the dispatch table points at.
+#define SAFE_ARRAY_KERNELS_FOR(Name, Target, Bytes)                                                                   \
+  template <typename T>                                                                                               \
+  struct Name {                                                                                                       \
+    typedef VectorKernels<T, Bytes> Kernels;                                                                          \
+    __attribute__((target(Target))) static void fill(T* data, const std::size_t n, const T value) {                   \
+      Kernels::fill(data, n, value);                                                                                  \
+    }                                                                                                                 \
+    __attribute__((target(Target))) static void iota(T* data, const std::size_t n, const T value) {                   \
+      Kernels::iota(data, n, value);                                                                                  \
+    }                                                                                                                 \
+    __attribute__((target(Target))) static T sum(const T* data, const std::size_t n) { return Kernels::sum(data, n); } \
+    __attribute__((target(Target))) static void minmax(const T* data, const std::size_t n, T& low, T& high) {         \
+      Kernels::minmax(data, n, low, high);                                                                            \
+    }                                                                                                                 \
+    __attribute__((target(Target))) static void scale(T* data, const std::size_t n, const T factor) {                 \
+      Kernels::scale(data, n, factor);                                                                                \
+    }                                                                                                                 \
+    __attribute__((target(Target))) static void axpy(T* y, const T* x, const std::size_t n, const T a) {              \
+      Kernels::axpy(y, x, n, a);                                                                                      \
+    }                                                                                                                 \
+    template <Comparison C>                                                                                           \
+    __attribute__((target(Target))) static std::size_t countIf(const T* data, const std::size_t n, const T value) {   \
+      return Kernels::template countIf<C>(data, n, value);                                                            \
+    }                                                                                                                 \
+    __attribute__((target(Target))) static std::size_t find(const T* data, const std::size_t n, const T value) {      \
+      return Kernels::find(data, n, value);                                                                           \
+    }                                                                                                                 \
+  };
+
+SAFE_ARRAY_KERNELS_FOR(Sse2Kernels, "sse2", 16)
+SAFE_ARRAY_KERNELS_FOR(Avx2Kernels, "avx2", 32)
+SAFE_ARRAY_KERNELS_FOR(Avx512Kernels, "avx512f", 64)
+#undef SAFE_ARRAY_KERNELS_FOR
+#endif
+
+template <typename T>
+struct BulkKernelTable {
+  void (*fill)(T*, const std::size_t, const T);
+  void (*iota)(T*, const std::size_t, const T);
+  T (*sum)(const T*, const std::size_t);
+  void (*minmax)(const T*, const std::size_t, T&, T&);
+  void (*scale)(T*, const std::size_t, const T);
+  void (*axpy)(T*, const T*, const std::size_t, const T);
+  std::size_t (*countIf[6])(const T*, const std::size_t, const T);
+  std::size_t (*find)(const T*, const std::size_t, const T);
+};
+
+template <typename T, template <typename> class Kernels>
+BulkKernelTable<T> makeBulkKernelTable() {
+  return { &Kernels<T>::fill,
+           &Kernels<T>::iota,
+           &Kernels<T>::sum,
+           &Kernels<T>::minmax,
+           &Kernels<T>::scale,
+           &Kernels<T>::axpy,
+           { &Kernels<T>::template countIf<Comparison::LESS>, &Kernels<T>::template countIf<Comparison::LESS_EQUAL>,
+             &Kernels<T>::template countIf<Comparison::EQUAL>, &Kernels<T>::template countIf<Comparison::NOT_EQUAL>,
+             &Kernels<T>::template countIf<Comparison::GREATER_EQUAL>, &Kernels<T>::template countIf<Comparison::GREATER> },
+           &Kernels<T>::find };
+}
+
+// The widest instruction set this CPU has.
+inline SimdLevel detectSimdLevel() {
+#ifdef SAFE_ARRAY_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SimdLevel::SSE2;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+inline SimdLevel& activeSimdLevel() {
+  static SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+// Lets the benchmark hold the kernels down to a narrower instruction set.  It can't go past what the CPU has.
+inline void setSimdLevel(const SimdLevel level) {
+  activeSimdLevel() = level < detectSimdLevel() ? level : detectSimdLevel();
+}
+
+inline const char* simdLevelName(const SimdLevel level) {
+  switch (level) {
+  case SimdLevel::SSE2:
+    return "SSE2";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  case SimdLevel::AVX512:
+    return "AVX-512";
+  default:
+    return "scalar";
+  }
+}
+
+// The table for the active level.  Only for types with vector kernels.
+template <typename T>
+const BulkKernelTable<T>& bulkKernelTable() {
+  static const BulkKernelTable<T> scalar = makeBulkKernelTable<T, ScalarKernels>();
+#ifdef SAFE_ARRAY_SIMD
+  static const BulkKernelTable<T> sse2 = makeBulkKernelTable<T, Sse2Kernels>();
+  static const BulkKernelTable<T> avx2 = makeBulkKernelTable<T, Avx2Kernels>();
+  static const BulkKernelTable<T> avx512 = makeBulkKernelTable<T, Avx512Kernels>();
+  switch (activeSimdLevel()) {
+  case SimdLevel::AVX512:
+    return avx512;
+  case SimdLevel::AVX2:
+    return avx2;
+  case SimdLevel::SSE2:
+    return sse2;
+  default:
+    break;
+  }
+#endif
+  return scalar;
+}
+
+// What SafeArray calls.  Types without vector kernels go straight to the scalar loops, so
+// only the kernels actually used have to compile for them.
+template <typename T, bool Vectorized = hasVectorKernels<T>>
+struct BulkKernels : ScalarKernels<T> {
+  static std::size_t countIf(const Comparison comparison, const T* data, const std::size_t n, const T value) {
+    switch (comparison) {
+    case Comparison::LESS:
+      return ScalarKernels<T>::template countIf<Comparison::LESS>(data, n, value);
+    case Comparison::LESS_EQUAL:
+      return ScalarKernels<T>::template countIf<Comparison::LESS_EQUAL>(data, n, value);
+    case Comparison::EQUAL:
+      return ScalarKernels<T>::template countIf<Comparison::EQUAL>(data, n, value);
+    case Comparison::NOT_EQUAL:
+      return ScalarKernels<T>::template countIf<Comparison::NOT_EQUAL>(data, n, value);
+    case Comparison::GREATER_EQUAL:
+      return ScalarKernels<T>::template countIf<Comparison::GREATER_EQUAL>(data, n, value);
+    default:
+      return ScalarKernels<T>::template countIf<Comparison::GREATER>(data, n, value);
+    }
+  }
+};
+
+template <typename T>
+struct BulkKernels<T, true> {
+  static void fill(T* data, const std::size_t n, const T value) { bulkKernelTable<T>().fill(data, n, value); }
+  static void iota(T* data, const std::size_t n, const T value) { bulkKernelTable<T>().iota(data, n, value); }
+  static T sum(const T* data, const std::size_t n) { return bulkKernelTable<T>().sum(data, n); }
+  static void minmax(const T* data, const std::size_t n, T& low, T& high) { bulkKernelTable<T>().minmax(data, n, low, high); }
+  static void scale(T* data, const std::size_t n, const T factor) { bulkKernelTable<T>().scale(data, n, factor); }
+  static void axpy(T* y, const T* x, const std::size_t n, const T a) { bulkKernelTable<T>().axpy(y, x, n, a); }
+  static std::size_t countIf(const Comparison comparison, const T* data, const std::size_t n, const T value) {
+    return bulkKernelTable<T>().countIf[static_cast<int>(comparison)](data, n, value);
+  }
+  static std::size_t find(const T* data, const std::size_t n, const T value) { return bulkKernelTable<T>().find(data, n, value); }
+};
+
+template <typename T, typename CheckPolicy = LogOnceOnOutOfBounds>
 class SafeArray {
 public:
-  SafeArray(const unsigned int capacity);
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  // alignment is in bytes, a power of two.  64 lines the items up with cache lines and vector loads.
+  SafeArray(const unsigned int capacity, const std::size_t alignment = alignof(T));
   ~SafeArray();
-  void item(const unsigned int index, const int value);
-  int get(const unsigned int index) const;
+  SafeArray(const SafeArray&) = delete;
+  SafeArray& operator=(const SafeArray&) = delete;
+  void item(const unsigned int index, const T& value);
+  T get(const unsigned int index) const;
+  T& operator[](const unsigned int index);
+  const T& operator[](const unsigned int index) const;
+
+  T* data() { return arr; }
+  const T* data() const { return arr; }
+  unsigned int size() const { return capacity; }
+  iterator begin() { return arr; }
+  iterator end() { return arr + capacity; }
+  const_iterator begin() const { return arr; }
+  const_iterator end() const { return arr + capacity; }
+
+  // Bulk operations over every item, run with the vector kernels when T has them.
+  void fill(const T& value) { BulkKernels<T>::fill(arr, capacity, value); }
+  void iota(const T& start) { BulkKernels<T>::iota(arr, capacity, start); }
+  T sum() const { return BulkKernels<T>::sum(arr, capacity); }
+  // The smallest and largest items, or two T{} for an empty array.
+  std::pair<T, T> minmax() const;
+  void scale(const T& factor) { BulkKernels<T>::scale(arr, capacity, factor); }
+  // Adds a times each item of x to the same item here.  x should be the same size; if it isn't,
+  // the policy's sizeMismatch() is told, and only the items both have are changed.
+  template <typename OtherPolicy>
+  void axpy(const T& a, const SafeArray<T, OtherPolicy>& x);
+  unsigned int count_if(const Comparison comparison, const T& value) const;
+  template <typename Predicate>
+  unsigned int count_if(Predicate predicate) const;
+  // The index of the first item equal to value, or size() if there isn't one.
+  unsigned int find(const T& value) const {
+    return static_cast<unsigned int>(BulkKernels<T>::find(arr, capacity, value));
+  }
 
 private:
-  int* arr{ nullptr };
+  bool inBounds(const unsigned int index) const;
+  // Where operator[] points when the policy lets a bad index through, so nothing real is touched.
+  static T& throwaway() {
+    static T item{};
+    item = T{};
+    return item;
+  }
+
+  T* arr{ nullptr };
   unsigned int capacity{ 0 };
+  std::size_t alignment{ alignof(T) };
 };
 
-SafeArray::SafeArray(const unsigned int capacity) {
-  arr = new int[capacity];
+template <typename T, typename CheckPolicy>
+SafeArray<T, CheckPolicy>::SafeArray(const unsigned int capacity, const std::size_t alignment) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    throw std::invalid_argument("The alignment has to be a power of two");
+  }
+  this->alignment = alignment > alignof(T) ? alignment : alignof(T);
+  arr = static_cast<T*>(::operator new(sizeof(T) * capacity, std::align_val_t(this->alignment)));
+  try {
+    std::uninitialized_value_construct_n(arr, capacity);
+  } catch (...) {
+    ::operator delete(arr, std::align_val_t(this->alignment));
+    throw;
+  }
   this->capacity = capacity;
 }
 
-SafeArray::~SafeArray() {
-  delete[] arr;
+template <typename T, typename CheckPolicy>
+SafeArray<T, CheckPolicy>::~SafeArray() {
+  std::destroy_n(arr, capacity);
+  ::operator delete(arr, std::align_val_t(alignment));
 }
 
-void SafeArray::item(const unsigned int index, const int value) {
-  if (index >= capacity) {
-    cout << "Index is out of bounds" << endl;
-  } else {
+template <typename T, typename CheckPolicy>
+bool SafeArray<T, CheckPolicy>::inBounds(const unsigned int index) const {
+  if constexpr (CheckPolicy::checks) {
+    if (index >= capacity) {
+      CheckPolicy::outOfBounds(index);
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T, typename CheckPolicy>
+void SafeArray<T, CheckPolicy>::item(const unsigned int index, const T& value) {
+  if (inBounds(index)) {
     arr[index] = value;
   }
 }
 
-int SafeArray::get(const unsigned int index) const {
-  return arr[index];
+template <typename T, typename CheckPolicy>
+T SafeArray<T, CheckPolicy>::get(const unsigned int index) const {
+  return inBounds(index) ? arr[index] : T{};
+}
+
+template <typename T, typename CheckPolicy>
+T& SafeArray<T, CheckPolicy>::operator[](const unsigned int index) {
+  return inBounds(index) ? arr[index] : throwaway();
+}
+
+template <typename T, typename CheckPolicy>
+const T& SafeArray<T, CheckPolicy>::operator[](const unsigned int index) const {
+  return inBounds(index) ? arr[index] : throwaway();
+}
+
+template <typename T, typename CheckPolicy>
+std::pair<T, T> SafeArray<T, CheckPolicy>::minmax() const {
+  std::pair<T, T> result{};
+  if (capacity > 0) {
+    BulkKernels<T>::minmax(arr, capacity, result.first, result.second);
+  }
+  return result;
+}
+
+template <typename T, typename CheckPolicy>
+template <typename OtherPolicy>
+void SafeArray<T, CheckPolicy>::axpy(const T& a, const SafeArray<T, OtherPolicy>& x) {
+  if (x.size() != capacity) {
+    CheckPolicy::sizeMismatch(capacity, x.size());
+  }
+  BulkKernels<T>::axpy(arr, x.data(), x.size() < capacity ? x.size() : capacity, a);
+}
+
+template <typename T, typename CheckPolicy>
+unsigned int SafeArray<T, CheckPolicy>::count_if(const Comparison comparison, const T& value) const {
+  return static_cast<unsigned int>(BulkKernels<T>::countIf(comparison, arr, capacity, value));
+}
+
+// For conditions a Comparison can't say.  This one goes an item at a time.
+template <typename T, typename CheckPolicy>
+template <typename Predicate>
+unsigned int SafeArray<T, CheckPolicy>::count_if(Predicate predicate) const {
+  unsigned int count = 0;
+  for (unsigned int i = 0; i < capacity; i++) {
+    count += predicate(arr[i]) ? 1 : 0;
+  }
+  return count;
+}
+
+template <typename Array>
+double measureSum(const Array& values, const unsigned int count, long long& total) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int repeat = 0; repeat < 100; repeat++) {
+    for (unsigned int i = 0; i < count; i++) {
+      total += values[i];
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::micro> diff = end - start;
+  return diff.count() / 1000.0;
+}
+
+// The unchecked policy times the same as the raw array, since with g++ -O2 the two summing
+// loops inlined here come out as the same instructions (see g++ -O2 -S), so its ratio to the
+// raw array should be about 1.
+void benchmarkSafeArray() {
+  const unsigned int count = 1000000;
+  int* raw = new int[count];
+  SafeArray<int, Unchecked> unchecked(count);
+  SafeArray<int, ThrowOnOutOfBounds> checked(count);
+  for (unsigned int i = 0; i < count; i++) {
+    raw[i] = i % 100;
+    unchecked[i] = i % 100;
+    checked[i] = i % 100;
+  }
+  long long total = 0;
+  const double rawTime = measureSum(const_cast<const int*>(raw), count, total);
+  const double uncheckedTime = measureSum(unchecked, count, total);
+  const double checkedTime = measureSum(checked, count, total);
+  cout << "Summing 1,000,000 ints 100 times took, in milliseconds:" << endl;
+  cout << "    raw array " << rawTime << endl;
+  cout << "    unchecked " << uncheckedTime << " (" << uncheckedTime / rawTime << " times the raw array)" << endl;
+  cout << "    throwing  " << checkedTime << " (" << checkedTime / rawTime << " times the raw array, checksum " << total
+       << ")" << endl;
+  delete[] raw;
 }
 
-int main() {
-  SafeArray myObject(10);
+// Times every bulk kernel at one instruction set level, repeats times over, and keeps what each
+// one gave back so the levels can be checked against each other.
+struct BulkKernelRun {
+  double milliseconds[8]{};
+  double sum{ 0 };
+  double low{ 0 };
+  double high{ 0 };
+  unsigned int count{ 0 };
+  unsigned int found{ 0 };
+  double checksum{ 0 };
+};
+
+const char* const bulkKernelNames[8] = { "fill", "iota", "scale", "sum", "minmax", "count_if", "find", "axpy" };
+
+template <typename T>
+BulkKernelRun runBulkKernels(const SimdLevel level, const unsigned int size, const unsigned int repeats) {
+  setSimdLevel(level);
+  SafeArray<T, Unchecked> y(size, 64);
+  SafeArray<T, Unchecked> x(size, 64);
+  BulkKernelRun run;
+  int kernel = 0;
+  auto time = [&run, &kernel, repeats](auto work) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++) {
+      work();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::micro> diff = end - start;
+    run.milliseconds[kernel++] = diff.count() / 1000.0;
+  };
+  // Everything stays small enough that an int can't overflow and a float holds it exactly (main
+  // keeps float sizes to 2^24), so every level has to come out the same apart from the float sum's
+  // rounding.
+  time([&y]() { y.fill(T(1)); });
+  time([&x]() { x.iota(T(0)); });
+  time([&y]() { y.scale(T(-1)); });
+  time([&y, &run]() { run.sum = static_cast<double>(y.sum()); });
+  time([&x, &run]() {
+    std::pair<T, T> lowHigh = x.minmax();
+    run.low = static_cast<double>(lowHigh.first);
+    run.high = static_cast<double>(lowHigh.second);
+  });
+  time([&x, &run, size]() { run.count = x.count_if(Comparison::GREATER_EQUAL, T(size / 2)); });
+  time([&x, &run, size]() { run.found = x.find(T(size - 1)); });
+  time([&x, &y]() { y.axpy(T(2), x); });
+  for (unsigned int i = 0; i < size; i += 997) {
+    run.checksum += static_cast<double>(y[i]);
+  }
+  run.checksum += static_cast<double>(y[size - 1]);
+  return run;
+}
+
+template <typename T>
+void benchmarkBulkKernelsFor(const char* typeName, const unsigned int maxSize) {
+  const SimdLevel detected = detectSimdLevel();
+  cout << "Bulk kernels on " << typeName << ", scalar against " << simdLevelName(detected)
+       << ", milliseconds per 10,000,000 items:" << endl;
+  for (unsigned int size = 1000; size <= maxSize; size = size > maxSize / 10 ? maxSize + 1 : size * 10) {
+    const unsigned int repeats = size < 10000000 ? 10000000 / size : 1;
+    const BulkKernelRun scalar = runBulkKernels<T>(SimdLevel::SCALAR, size, repeats);
+    const BulkKernelRun vector = runBulkKernels<T>(detected, size, repeats);
+    const double perTenMillion = 10000000.0 / (static_cast<double>(size) * repeats);
+    cout << "    " << size << " items:" << endl;
+    for (int kernel = 0; kernel < 8; kernel++) {
+      cout << "        " << bulkKernelNames[kernel] << " " << scalar.milliseconds[kernel] * perTenMillion << " against "
+           << vector.milliseconds[kernel] * perTenMillion << ", "
+           << scalar.milliseconds[kernel] / vector.milliseconds[kernel] << " times as fast" << endl;
+    }
+    double sumError = scalar.sum - vector.sum;
+    sumError = sumError < 0 ? -sumError : sumError;
+    if (sumError > 1e-4 * (scalar.sum < 0 ? -scalar.sum : scalar.sum) || scalar.low != vector.low || scalar.high != vector.high
+        || scalar.count != vector.count || scalar.found != vector.found || scalar.checksum != vector.checksum) {
+      cout << "*** The " << simdLevelName(detected) << " kernels didn't give the same results as the scalar ones" << endl;
+    }
+  }
+  setSimdLevel(detected);
+}
+
+// Runs every bulk kernel at every vector level the CPU has against ScalarKernels, over lengths
+// that end partway through a vector and starting off a vector boundary, and says which differ.
+template <typename T>
+void testBulkKernelsFor(const char* typeName) {
+  const SimdLevel detected = detectSimdLevel();
+  const std::size_t maxLength = 300;
+  // Room to start up to 15 items past an aligned address.
+  SafeArray<T, Unchecked> x(maxLength + 16, 64);
+  SafeArray<T, Unchecked> y(maxLength + 16, 64);
+  SafeArray<T, Unchecked> expected(maxLength + 16, 64);
+  const SimdLevel levels[3] = { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+  for (const SimdLevel level : levels) {
+    if (level > detected) {
+      cout << "Skipped testBulkKernels " << typeName << " " << simdLevelName(level) << ", this CPU doesn't have it" << endl;
+      continue;
+    }
+    setSimdLevel(level);
+    const char* failed = nullptr;
+    std::size_t failedLength = 0;
+    for (std::size_t n = 0; n <= maxLength && !failed; n++) {
+      const std::size_t offset = n % 16;
+      T* xs = x.data() + offset;
+      T* ys = y.data() + offset;
+      T* want = expected.data() + offset;
+      // Small whole numbers, so every sum and product is exact even for float.
+      for (std::size_t i = 0; i < n; i++) {
+        xs[i] = static_cast<T>(static_cast<int>((i * 37 + n) % 101) - 50);
+      }
+      const T last = n > 0 ? xs[n - 1] : T(0);
+
+      if (BulkKernels<T>::sum(xs, n) != ScalarKernels<T>::sum(xs, n)) {
+        failed = "sum";
+      }
+      T low = T(1), high = T(-1), scalarLow = T(1), scalarHigh = T(-1);
+      if (n > 0) {
+        BulkKernels<T>::minmax(xs, n, low, high);
+        ScalarKernels<T>::minmax(xs, n, scalarLow, scalarHigh);
+      }
+      if (low != scalarLow || high != scalarHigh) {
+        failed = "minmax";
+      }
+      for (int c = 0; c < 6; c++) {
+        const Comparison comparison = static_cast<Comparison>(c);
+        if (BulkKernels<T>::countIf(comparison, xs, n, last) != BulkKernels<T, false>::countIf(comparison, xs, n, last)) {
+          failed = "count_if";
+        }
+      }
+      if (BulkKernels<T>::find(xs, n, last) != ScalarKernels<T>::find(xs, n, last)
+          || BulkKernels<T>::find(xs, n, T(99)) != ScalarKernels<T>::find(xs, n, T(99))) {
+        failed = "find";
+      }
+
+      BulkKernels<T>::iota(ys, n, T(-7));
+      ScalarKernels<T>::iota(want, n, T(-7));
+      if (!std::equal(ys, ys + n, want)) {
+        failed = "iota";
+      }
+      BulkKernels<T>::scale(ys, n, T(-2));
+      ScalarKernels<T>::scale(want, n, T(-2));
+      if (!std::equal(ys, ys + n, want)) {
+        failed = "scale";
+      }
+      BulkKernels<T>::axpy(ys, xs, n, T(3));
+      ScalarKernels<T>::axpy(want, xs, n, T(3));
+      if (!std::equal(ys, ys + n, want)) {
+        failed = "axpy";
+      }
+      BulkKernels<T>::fill(ys, n, T(5));
+      ScalarKernels<T>::fill(want, n, T(5));
+      if (!std::equal(ys, ys + n, want)) {
+        failed = "fill";
+      }
+      failedLength = n;
+    }
+    if (failed) {
+      cout << "****** Failed test testBulkKernels " << typeName << " " << simdLevelName(level) << " ****** " << endl
+           << "     " << failed << " differs from the scalar kernel for " << failedLength << " items" << endl;
+    } else {
+      cout << "Passed testBulkKernels " << typeName << " " << simdLevelName(level) << endl;
+    }
+  }
+  setSimdLevel(detected);
+}
+
+int main(int argc, char* argv[]) {
+  SafeArray<int> myObject(10);
   myObject.item(1, 1);
   myObject.item(2, 8);
   myObject.item(3, 27);
   myObject.item(4, 64);
   myObject.item(10, 1000);
+  myObject[11] = 1000;
   cout << myObject.get(4) << endl;
+
+  SafeArray<int, ThrowOnOutOfBounds> checked(10);
+  try {
+    checked[10] = 1000;
+  } catch (const std::out_of_range& e) {
+    cout << e.what() << endl;
+  }
+
+  testBulkKernelsFor<float>("float");
+  testBulkKernelsFor<int>("int");
+  benchmarkSafeArray();
+  // The bulk kernel benchmark goes up to 100,000,000 items unless given a smaller top size. Floats
+  // stop at 2^24, past which a float can't count by ones, so a plain float sum gets stuck there.
+  const unsigned int maxSize = argc > 1 ? static_cast<unsigned int>(std::stoul(argv[1])) : 100000000;
+  const unsigned int maxExactFloat = 1u << 24;
+  benchmarkBulkKernelsFor<float>("float", maxSize < maxExactFloat ? maxSize : maxExactFloat);
+  benchmarkBulkKernelsFor<int>("int", maxSize);
   cin.get();
   return 0;
 }
@@ -0,0 +1,115 @@
+#include "benchmark.h"
+#include "stringbuilder.h"
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+using namespace std;
+
+// how `StringBuilder::operator*()` used to repeat its content, for comparison
+// (`StringBuilder` kept a single `string` then)
+static void repeatByLoop(string& content, unsigned int n) {
+  if (n > 1) {
+    string original = content;
+    for (unsigned int i = 1; i < n; i++) {
+      content += original;
+    }
+  }
+}
+
+// times `*` against the loop it replaced, for a few sizes of `n`
+static void benchmarkRepeat() {
+  const string text = "Hello, world! ";
+  cout << "Repeating a " << text.size() << " character string n times, in milliseconds:" << endl;
+  for (unsigned int n : {10u, 1000u, 1000000u}) {
+    // small n finish too fast to time once, so they run enough times to add up to 1e6 copies
+    unsigned int rounds = 1000000 / n;
+    size_t checksum = 0;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned int round = 0; round < rounds; round++) {
+      string content = text;
+      repeatByLoop(content, n);
+      checksum += content.size();
+    }
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double, milli> loop = end - start;
+
+    start = chrono::high_resolution_clock::now();
+    for (unsigned int round = 0; round < rounds; round++) {
+      StringBuilder sb(text);
+      sb * n;
+      checksum += sb.str().size();
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double, milli> doubling = end - start;
+
+    cout << "  n = " << n << " (" << rounds << " times): loop " << loop.count()
+         << ", doubling " << doubling.count() << " (" << checksum << " characters)" << endl;
+  }
+}
+
+// returns the most memory the process has held at once, in MiB
+static double peakMemoryMiB() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+// appends the lines of a report `lines` long to `sb`
+static void buildReport(StringBuilder& sb, unsigned int lines) {
+  for (unsigned int i = 0; i < lines; i++) {
+    sb.append("row ");
+    sb.append(to_string(i));
+    sb.append(": the quick brown fox jumps over the lazy dog\n");
+  }
+}
+
+// times writing a large report to /dev/null from a streaming `StringBuilder`
+// against building it all first and writing it at the end; the streaming one
+// goes first, since the peak memory can only go up
+static void benchmarkStreaming() {
+  const unsigned int lines = 4000000;
+  int fd = open("/dev/null", O_WRONLY);
+  if (fd < 0) {
+    cout << "Couldn't open /dev/null, skipping the streaming benchmark" << endl;
+    return;
+  }
+  cout << "Writing a " << lines << " line report to /dev/null:" << endl;
+  double before = peakMemoryMiB();
+
+  auto start = chrono::high_resolution_clock::now();
+  {
+    StringBuilder sb(fd);
+    buildReport(sb, lines);
+  }
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> streaming = end - start;
+  double streamingPeak = peakMemoryMiB();
+
+  start = chrono::high_resolution_clock::now();
+  {
+    StringBuilder sb;
+    buildReport(sb, lines);
+    const string& report = sb.str();
+    if (write(fd, report.data(), report.size()) < 0) {
+      cout << "  writing the report failed" << endl;
+    }
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> accumulated = end - start;
+  double accumulatedPeak = peakMemoryMiB();
+  close(fd);
+
+  cout << "  streaming: " << streaming.count() << " ms, peak memory grew "
+       << streamingPeak - before << " MiB" << endl;
+  cout << "  built first: " << accumulated.count() << " ms, peak memory grew "
+       << accumulatedPeak - before << " MiB" << endl;
+}
+
+void runBenchmarks() {
+  benchmarkRepeat();
+  benchmarkStreaming();
+}
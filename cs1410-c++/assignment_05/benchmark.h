@@ -0,0 +1,7 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// runs the `StringBuilder` benchmarks, for `./run --bench`
+void runBenchmarks();
+
+#endif
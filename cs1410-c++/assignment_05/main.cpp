@@ -1,9 +1,21 @@
+#include "benchmark.h"
 #include "stringbuilder.h"
+#include "tests.h"
 #include <iostream>
 #include <string>
 using namespace std;
 
 int main(int argc, char const* argv[]) {
+  // `./run --bench` times the `StringBuilder` instead of demonstrating it
+  if (argc > 1 && string(argv[1]) == "--bench") {
+    runBenchmarks();
+    return 0;
+  }
+  // `./run --test` checks the `StringBuilder` and exits with 1 if anything failed
+  if (argc > 1 && string(argv[1]) == "--test") {
+    return runTests() == 0 ? 0 : 1;
+  }
+
   // use both constructors
   StringBuilder sb1;
   StringBuilder sb2("Hello, world!");
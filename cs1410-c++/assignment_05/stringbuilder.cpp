@@ -1,40 +1,329 @@
 #include "stringbuilder.h"
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
 using namespace std;
 
-// constructor: initializes `content` to an empty string
-StringBuilder::StringBuilder() { this->content = ""; }
-// constructor: initializes `content` to `str`
-StringBuilder::StringBuilder(const string& str) { this->content = str; }
-// destructor
-StringBuilder::~StringBuilder() {}
-
-// a method I chose to add for convenience
-void StringBuilder::append(string str) { this->content += str; }
-// returns the contents of a `StringBuilder` object
-const string& StringBuilder::str() const { return this->content; }
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// new chunks are at least this big, and at most this big unless one append needs more
+const size_t MIN_CHUNK_SIZE = 256;
+const size_t MAX_CHUNK_SIZE = 1 << 20;
+
+// constructor: starts out empty
+StringBuilder::StringBuilder() { this->length = 0; }
+// constructor: starts out holding `str`
+StringBuilder::StringBuilder(const string& str) {
+  this->length = 0;
+  this->append(str);
+}
+// constructor: starts out empty, streaming to `out`
+StringBuilder::StringBuilder(ostream& out, size_t flushKiB) {
+  this->length = 0;
+  this->sink.stream = &out;
+  this->sink.threshold = flushKiB * 1024;
+}
+// constructor: starts out empty, streaming to `file`
+StringBuilder::StringBuilder(FILE* file, size_t flushKiB) {
+  this->length = 0;
+  this->sink.file = file;
+  this->sink.threshold = flushKiB * 1024;
+}
+// constructor: starts out empty, streaming to the file descriptor `fd`
+StringBuilder::StringBuilder(int fd, size_t flushKiB) {
+  this->length = 0;
+  this->sink.fd = fd;
+  this->sink.threshold = flushKiB * 1024;
+}
+// destructor: a streaming `StringBuilder` writes out whatever is left; there's
+// no one to tell if that fails, so errors are dropped
+StringBuilder::~StringBuilder() {
+  try {
+    this->flush();
+  } catch (...) {
+  }
+}
+
+// copy constructor: holds the same text, but doesn't stream anywhere
+StringBuilder::StringBuilder(const StringBuilder& sb)
+    : joined(sb.joined), chunks(sb.chunks), length(sb.length), sink(sb.sink) {}
+// move constructor: takes the text and the sink, leaving `sb` empty
+StringBuilder::StringBuilder(StringBuilder&& sb) noexcept
+    : joined(move(sb.joined)), chunks(move(sb.chunks)), length(sb.length), sink(move(sb.sink)) {
+  sb.joined.clear();
+  sb.chunks.clear();
+  sb.length = 0;
+}
+// copy assignment: a streaming `StringBuilder` writes out what it had first,
+// then holds the same text as `sb`, still streaming to its own sink
+StringBuilder& StringBuilder::operator=(const StringBuilder& sb) {
+  if (this != &sb) {
+    this->flush();
+    this->joined = sb.joined;
+    this->chunks = sb.chunks;
+    this->length = sb.length;
+  }
+  return *this;
+}
+// move assignment: a streaming `StringBuilder` writes out what it had first,
+// then takes the text and the sink from `sb`, leaving it empty
+StringBuilder& StringBuilder::operator=(StringBuilder&& sb) {
+  if (this != &sb) {
+    this->flush();
+    this->joined = move(sb.joined);
+    this->chunks = move(sb.chunks);
+    this->length = sb.length;
+    this->sink = move(sb.sink);
+    sb.joined.clear();
+    sb.chunks.clear();
+    sb.length = 0;
+  }
+  return *this;
+}
+
+StringBuilder::Sink::Sink(Sink&& other) noexcept
+    : stream(other.stream), file(other.file), fd(other.fd), threshold(other.threshold) {
+  other.stream = nullptr;
+  other.file = nullptr;
+  other.fd = -1;
+}
+StringBuilder::Sink& StringBuilder::Sink::operator=(Sink&& other) noexcept {
+  if (this != &other) {
+    this->stream = other.stream;
+    this->file = other.file;
+    this->fd = other.fd;
+    this->threshold = other.threshold;
+    other.stream = nullptr;
+    other.file = nullptr;
+    other.fd = -1;
+  }
+  return *this;
+}
+
+// writes `iov` out in as few `writev()` calls as it takes, picking up where a
+// short write left off
+static void writeAll(int fd, vector<iovec>& iov) {
+  size_t next = 0;
+  while (next < iov.size()) {
+    int count = iov.size() - next < IOV_MAX ? iov.size() - next : IOV_MAX;
+    ssize_t written = writev(fd, &iov[next], count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw system_error(errno, generic_category(), "StringBuilder: writing to the sink failed");
+    }
+    size_t left = written;
+    while (next < iov.size() && left >= iov[next].iov_len) {
+      left -= iov[next].iov_len;
+      next++;
+    }
+    if (left > 0) {
+      iov[next].iov_base = static_cast<char*>(iov[next].iov_base) + left;
+      iov[next].iov_len -= left;
+    }
+  }
+}
+
+// returns the chunk the next `n` characters fit in, starting a new one if the
+// last is full; a new chunk is about as big as everything so far, so there are
+// only a few of them however many appends there are
+string& StringBuilder::roomFor(size_t n) {
+  if (this->chunks.empty() ||
+      this->chunks.back().capacity() - this->chunks.back().size() < n) {
+    size_t chunkSize = this->length < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE
+                       : this->length > MAX_CHUNK_SIZE ? MAX_CHUNK_SIZE
+                                                       : this->length;
+    this->chunks.emplace_back();
+    this->chunks.back().reserve(n > chunkSize ? n : chunkSize);
+  }
+  return this->chunks.back();
+}
+// makes `text` hold what it holds now `n` times in a row; it's grown once to
+// its final size, and filled by copying what's already there onto its end, so
+// it takes about log2(n) copies
+static void repeatInPlace(string& text, unsigned int n) {
+  if (n == 0) {
+    text.clear();
+    return;
+  }
+  if (text.size() > text.max_size() / n) {
+    throw length_error("StringBuilder: repeated content is too long");
+  }
+  size_t total = text.size() * n;
+  size_t filled = text.size();
+  text.resize(total);
+  while (filled < total) {
+    size_t copied = filled < total - filled ? filled : total - filled;
+    memcpy(&text[filled], text.data(), copied);
+    filled += copied;
+  }
+}
+
+// joins the chunks onto the end of `joined`, for anything that needs the text
+// in one piece; a single chunk is swapped in rather than copied
+void StringBuilder::flatten() const {
+  if (this->chunks.empty()) {
+    return;
+  }
+  if (this->joined.empty() && this->chunks.size() == 1) {
+    this->joined.swap(this->chunks.front());
+  } else {
+    this->joined.reserve(this->length);
+    for (const string& chunk : this->chunks) {
+      this->joined += chunk;
+    }
+  }
+  this->chunks.clear();
+}
+
+// writes the content, followed by `extra`, to the sink, and lets go of it;
+// with a file or file descriptor it all goes out in one `writev()`, straight
+// from the chunks; the last chunk is kept, emptied, to buffer what comes next;
+// if the sink fails, a `system_error` is thrown and the content is kept
+void StringBuilder::writeOut(string_view extra) {
+  if (this->sink.stream) {
+    this->sink.stream->write(this->joined.data(), this->joined.size());
+    for (const string& chunk : this->chunks) {
+      this->sink.stream->write(chunk.data(), chunk.size());
+    }
+    this->sink.stream->write(extra.data(), extra.size());
+    if (this->sink.stream->fail()) {
+      throw system_error(make_error_code(errc::io_error), "StringBuilder: writing to the sink failed");
+    }
+  } else {
+    if (this->sink.file) {
+      fflush(this->sink.file);
+    }
+    vector<iovec> iov;
+    iov.reserve(this->chunks.size() + 2);
+    if (!this->joined.empty()) {
+      iov.push_back({ &this->joined[0], this->joined.size() });
+    }
+    for (string& chunk : this->chunks) {
+      if (!chunk.empty()) {
+        iov.push_back({ &chunk[0], chunk.size() });
+      }
+    }
+    if (!extra.empty()) {
+      iov.push_back({ const_cast<char*>(extra.data()), extra.size() });
+    }
+    writeAll(this->sink.file ? fileno(this->sink.file) : this->sink.fd, iov);
+  }
+  this->joined.clear();
+  if (!this->chunks.empty() && this->chunks.back().capacity() <= 2 * this->sink.threshold) {
+    this->chunks.back().clear();
+    this->chunks.erase(this->chunks.begin(), this->chunks.end() - 1);
+  } else {
+    this->chunks.clear();
+  }
+  this->length = 0;
+}
+// writes everything held so far to the sink, if there is one
+void StringBuilder::flush() {
+  if (this->sink.bound() && this->length > 0) {
+    this->writeOut(string_view());
+  }
+}
+void StringBuilder::flushIfFull() {
+  if (this->sink.bound() && this->length >= this->sink.threshold) {
+    this->writeOut(string_view());
+  }
+}
+
+// copies `str` onto the end, without moving anything already appended; when
+// streaming, anything at least as big as the buffer goes straight to the sink
+void StringBuilder::append(string_view str) {
+  if (this->sink.bound() && str.size() >= this->sink.threshold) {
+    this->writeOut(str);
+  } else if (!str.empty()) {
+    this->roomFor(str.size()).append(str);
+    this->length += str.size();
+    this->flushIfFull();
+  }
+}
+void StringBuilder::append(const string& str) { this->append(string_view(str)); }
+void StringBuilder::append(const char* str) { this->append(string_view(str)); }
+// takes over `str` as a chunk of its own, so nothing is copied; short strings
+// are copied into the last chunk instead, if they fit, to keep chunks from piling up
+void StringBuilder::append(string&& str) {
+  size_t n = str.size();
+  if (n < MIN_CHUNK_SIZE && !this->chunks.empty() &&
+      this->chunks.back().capacity() - this->chunks.back().size() >= n) {
+    this->chunks.back() += str;
+  } else if (n > 0) {
+    this->chunks.push_back(move(str));
+  }
+  this->length += n;
+  this->flushIfFull();
+}
+// makes room for the content to grow to `n` characters without allocating again
+void StringBuilder::reserve(size_t n) {
+  if (n > this->length) {
+    this->roomFor(n - this->length);
+  }
+}
+// returns the number of characters in the `StringBuilder`; when streaming,
+// just the ones not written out yet
+size_t StringBuilder::size() const { return this->length; }
+// returns the contents of a `StringBuilder` object; when streaming, just what
+// hasn't been written out yet; the reference stays valid for as long as the
+// `StringBuilder` does, and shows later appends once `str()` is called again
+const string& StringBuilder::str() const {
+  this->flatten();
+  return this->joined;
+}
+// returns the contents as one contiguous run of characters; like a view of
+// any `string`, it's invalidated by the next change to the content
+string_view StringBuilder::view() const { return this->str(); }
 // duplicates the content `n` times within the `StringBuilder`
 void StringBuilder::operator*(unsigned int n) {
-  if (n > 1) {
-    string original = this->content;
-    for (int i = 1; i < n; i++) {
-      this->content += original;
-    }
+  if (n > 1 && this->length > 0) {
+    this->flatten();
+    repeatInPlace(this->joined, n);
+    this->length = this->joined.size();
   }
 }
+// returns a new `StringBuilder` holding the content `n` times, leaving this one
+// alone; unlike `*`, repeating 0 times gives an empty one
+StringBuilder StringBuilder::repeat(unsigned int n) const {
+  string content = this->str();
+  repeatInPlace(content, n);
+  StringBuilder result;
+  result.append(move(content));
+  return result;
+}
 // compares whether the contents of two `StringBuilders` are equal
 bool StringBuilder::operator==(StringBuilder& sb) {
-  return this->content == sb.content;
+  return this->length == sb.length && this->str() == sb.str();
 }
 // compares whether the contents of two `StringBuilders` are different
 bool StringBuilder::operator!=(StringBuilder& sb) {
-  return !(this->content == sb.content);
+  return !(*this == sb);
+}
+// allows you to store a `string` value into a `StringBuilder`; a streaming one
+// writes out what it had first
+void operator>>(string str, StringBuilder& sb) {
+  sb.flush();
+  sb.joined.clear();
+  sb.chunks.clear();
+  sb.length = 0;
+  sb.append(move(str));
 }
-// allows you to store a `string` value into a `StringBuilder`
-void operator>>(string str, StringBuilder& sb) { sb.content = str; }
-// allows you to stream a `StringBuilder` into an output stream
+// allows you to stream a `StringBuilder` into an output stream, a chunk at a
+// time, so it never has to be joined
 ostream& operator<<(ostream& out, StringBuilder& sb) {
-  out << sb.content;
+  out.write(sb.joined.data(), sb.joined.size());
+  for (const string& chunk : sb.chunks) {
+    out.write(chunk.data(), chunk.size());
+  }
   return out;
 }
\ No newline at end of file
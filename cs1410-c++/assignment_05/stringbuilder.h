@@ -1,22 +1,71 @@
 #ifndef STRINGBUILDER_H
 #define STRINGBUILDER_H
 
+#include <cstddef>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 using namespace std;
 
 class StringBuilder {
 private:
-  string content;
+  // the text, in order: whatever `str()` last joined into one piece, then
+  // the chunks appended since, split over as many as it took to append them
+  // without moving what was already there; `joined` is always the same
+  // `string`, so the reference `str()` returns to it stays valid
+  mutable string joined;
+  mutable vector<string> chunks;
+  size_t length;
+
+  // where a streaming `StringBuilder` writes its content; a copy holds the same
+  // text but doesn't write anywhere, while a move takes the sink along
+  struct Sink {
+    ostream* stream = nullptr;
+    FILE* file = nullptr;
+    int fd = -1;
+    size_t threshold = 0;
+
+    Sink() = default;
+    Sink(const Sink&) {}
+    Sink(Sink&& other) noexcept;
+    Sink& operator=(const Sink&) { return *this; }
+    Sink& operator=(Sink&& other) noexcept;
+    bool bound() const { return this->stream || this->file || this->fd >= 0; }
+  };
+  Sink sink;
+
+  string& roomFor(size_t n);
+  void flatten() const;
+  void flushIfFull();
+  void writeOut(string_view extra);
 
 public:
   StringBuilder();
   StringBuilder(const string& str);
+  // streaming constructors: the content is written to the sink and let go of
+  // whenever `flushKiB` KiB of it have built up, and when the builder is destroyed
+  explicit StringBuilder(ostream& out, size_t flushKiB = 64);
+  explicit StringBuilder(FILE* file, size_t flushKiB = 64);
+  explicit StringBuilder(int fd, size_t flushKiB = 64);
   ~StringBuilder();
+  StringBuilder(const StringBuilder& sb);
+  StringBuilder(StringBuilder&& sb) noexcept;
+  StringBuilder& operator=(const StringBuilder& sb);
+  StringBuilder& operator=(StringBuilder&& sb);
 
-  void append(string str);
+  void append(string_view str);
+  void append(const string& str);
+  void append(const char* str);
+  void append(string&& str);
+  void reserve(size_t n);
+  void flush();
+  size_t size() const;
   const string& str() const;
+  string_view view() const;
   void operator*(unsigned int n);
+  StringBuilder repeat(unsigned int n) const;
   bool operator==(StringBuilder& sb);
   bool operator!=(StringBuilder& sb);
 
@@ -0,0 +1,188 @@
+#include "stringbuilder.h"
+#include "tests.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+using namespace std;
+
+static int failures = 0;
+
+// prints whether `actual` came out as `expected`
+static void checkTest(const string& testName, const string& expected, const string& actual) {
+  if (expected == actual) {
+    cout << "Passed " << testName << endl;
+  } else {
+    cout << "****** Failed test " << testName << " ****** " << endl
+         << "     Output was " << actual << endl
+         << "     Output should have been " << expected << endl;
+    failures++;
+  }
+}
+
+// moving a `StringBuilder` leaves the one moved from empty and usable
+static void testMove() {
+  StringBuilder a("x");
+  StringBuilder b(move(a));
+  a.append("y");
+  checkTest("testMove #1", "x", b.str());
+  checkTest("testMove #2", "y", a.str());
+  checkTest("testMove #3", "1", to_string(a.size()));
+
+  StringBuilder c("z");
+  c = move(b);
+  b.append("y");
+  checkTest("testMove #4", "x", c.str());
+  checkTest("testMove #5", "y", b.str());
+  checkTest("testMove #6", "1", to_string(b.size()));
+}
+
+// assigning over a streaming `StringBuilder` writes out what it had first
+static void testAssignOverStreaming() {
+  ostringstream out;
+  {
+    StringBuilder streaming(out, 1);
+    streaming.append("pending");
+    streaming = StringBuilder("moved");
+    checkTest("testAssignOverStreaming #1", "pending", out.str());
+    checkTest("testAssignOverStreaming #2", "moved", streaming.str());
+  }
+  checkTest("testAssignOverStreaming #3", "pending", out.str());
+
+  out.str("");
+  StringBuilder copied("copied");
+  {
+    StringBuilder streaming(out, 1);
+    streaming.append("pending");
+    streaming = copied;
+    checkTest("testAssignOverStreaming #4", "pending", out.str());
+  }
+  checkTest("testAssignOverStreaming #5", "pendingcopied", out.str());
+  checkTest("testAssignOverStreaming #6", "copied", copied.str());
+
+  // a move takes the sink along, a copy doesn't
+  out.str("");
+  {
+    StringBuilder streaming(out, 1);
+    streaming.append("streamed");
+    StringBuilder moved(move(streaming));
+    StringBuilder copy(moved);
+  }
+  checkTest("testAssignOverStreaming #7", "streamed", out.str());
+
+  StringBuilder self("self");
+  StringBuilder& alias = self;
+  self = alias;
+  self = move(alias);
+  checkTest("testAssignOverStreaming #8", "self", self.str());
+}
+
+// a stream that stops taking output is reported, and nothing is let go of
+static void testStreamFailure() {
+  ostringstream out;
+  out.setstate(ios::badbit);
+  StringBuilder streaming(out, 1);
+  streaming.append("lost");
+  string caught;
+  try {
+    streaming.flush();
+  } catch (const system_error& e) {
+    caught = e.what();
+  }
+  checkTest("testStreamFailure #1", "StringBuilder: writing to the sink failed: Input/output error", caught);
+  checkTest("testStreamFailure #2", "lost", streaming.str());
+}
+
+// the reference `str()` gives stays valid however much is appended after it
+static void testStrReference() {
+  StringBuilder sb("abc");
+  const string& text = sb.str();
+  sb.append(string(300, 'x'));
+  sb.append("yz");
+  checkTest("testStrReference #1", "abc", text);
+  checkTest("testStrReference #2", "305", to_string(sb.str().size()));
+  checkTest("testStrReference #3", "305", to_string(text.size()));
+  checkTest("testStrReference #4", "true", &text == &sb.str() ? "true" : "false");
+}
+
+// appends land in order however they're split over chunks
+static void testAppend() {
+  StringBuilder sb;
+  string expected;
+  for (int i = 0; i < 2000; i++) {
+    string piece = to_string(i) + (i % 7 == 0 ? string(300, 'a' + i % 26) : ",");
+    expected += piece;
+    if (i % 3 == 0) {
+      sb.append(move(piece));
+    } else if (i % 3 == 1) {
+      sb.append(piece);
+    } else {
+      sb.append(string_view(piece));
+    }
+  }
+  checkTest("testAppend #1", to_string(expected.size()), to_string(sb.size()));
+  checkTest("testAppend #2", expected, sb.str());
+  ostringstream out;
+  out << sb;
+  checkTest("testAppend #3", expected, out.str());
+  sb.append("");
+  sb.append(string());
+  checkTest("testAppend #4", to_string(expected.size()), to_string(sb.size()));
+  sb.reserve(expected.size() + 100);
+  sb.append("end");
+  checkTest("testAppend #5", expected + "end", sb.str());
+}
+
+// `*` repeats the content in place, leaving it alone for 0 and 1; `repeat()`
+// gives a new one and leaves the original alone
+static void testRepeat() {
+  StringBuilder sb("ab");
+  sb * 3;
+  checkTest("testRepeat #1", "ababab", sb.str());
+  sb * 1;
+  checkTest("testRepeat #2", "ababab", sb.str());
+  sb * 0;
+  checkTest("testRepeat #3", "ababab", sb.str());
+
+  StringBuilder empty;
+  empty * 5;
+  checkTest("testRepeat #4", "", empty.str());
+  checkTest("testRepeat #5", "0", to_string(empty.size()));
+  checkTest("testRepeat #6", "", empty.repeat(5).str());
+
+  // content spread over several chunks first
+  StringBuilder chunked;
+  string piece(1000, 'x');
+  piece += "|";
+  chunked.append(piece);
+  chunked.append(string(piece));
+  chunked.append(piece);
+  chunked * 4;
+  string expected;
+  for (int i = 0; i < 12; i++) {
+    expected += piece;
+  }
+  checkTest("testRepeat #7", expected, chunked.str());
+  checkTest("testRepeat #8", to_string(expected.size()), to_string(chunked.size()));
+
+  StringBuilder original("xy");
+  original.append("z");
+  StringBuilder repeated = original.repeat(3);
+  checkTest("testRepeat #9", "xyzxyzxyz", repeated.str());
+  checkTest("testRepeat #10", "xyz", original.str());
+  checkTest("testRepeat #11", "", original.repeat(0).str());
+  checkTest("testRepeat #12", "xyz", original.repeat(1).str());
+  checkTest("testRepeat #13", "xyz", original.str());
+}
+
+int runTests() {
+  failures = 0;
+  testAppend();
+  testRepeat();
+  testMove();
+  testAssignOverStreaming();
+  testStreamFailure();
+  testStrReference();
+  return failures;
+}
@@ -0,0 +1,7 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+// runs the `StringBuilder` tests, for `./run --test`, and returns how many failed
+int runTests();
+
+#endif
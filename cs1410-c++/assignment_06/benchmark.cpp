@@ -0,0 +1,386 @@
+#include "addition.h"
+#include "benchmark.h"
+#include "division.h"
+#include "multiplication.h"
+#include "operation.h"
+#include "operationbatch.h"
+#include "operationpipeline.h"
+#include "operationreader.h"
+#include "operationwriter.h"
+#include "operatorregistry.h"
+#include "registeredoperation.h"
+#include "subtraction.h"
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+// how `main()` used to evaluate one line: it made one of each `Operation` and
+// used the one matching `op`
+static double performByObjects(char op, double lhs, double rhs) {
+  Addition* add = new Addition(lhs, rhs);
+  Subtraction* sub = new Subtraction(lhs, rhs);
+  Multiplication* mul = new Multiplication(lhs, rhs);
+  Division* div = new Division(lhs, rhs);
+  double res = 0;
+  switch (op) {
+  case '+':
+    res = add->perform();
+    break;
+  case '-':
+    res = sub->perform();
+    break;
+  case '*':
+    res = mul->perform();
+    break;
+  case '/':
+    res = div->perform();
+    break;
+  default:
+    break;
+  }
+  delete add;
+  delete sub;
+  delete mul;
+  delete div;
+  return res;
+}
+
+// times evaluating a few million random operations one `Operation` at a time
+// against a batch at a time; nothing is read or written, just evaluated
+static void benchmarkBatch() {
+  const size_t count = 10000000;
+  const size_t batchSize = 1 << 16;
+  const char symbols[] = { '+', '-', '*', '/' };
+  mt19937 random(2420);
+  uniform_real_distribution<double> operand(1, 100);
+  vector<char> ops(count);
+  vector<double> lefts(count);
+  vector<double> rights(count);
+  for (size_t i = 0; i < count; i++) {
+    ops[i] = symbols[random() % 4];
+    lefts[i] = operand(random);
+    rights[i] = operand(random);
+  }
+  cout << "Evaluating " << count << " operations, in milliseconds:" << endl;
+
+  double checksum = 0;
+  auto start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    checksum += performByObjects(ops[i], lefts[i], rights[i]);
+  }
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> objects = end - start;
+  cout << "  an object for each operator: " << objects.count() << " (" << checksum << ")" << endl;
+
+  checksum = 0;
+  start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    Operation* opr;
+    switch (ops[i]) {
+    case '+':
+      opr = new Addition(lefts[i], rights[i]);
+      break;
+    case '-':
+      opr = new Subtraction(lefts[i], rights[i]);
+      break;
+    case '*':
+      opr = new Multiplication(lefts[i], rights[i]);
+      break;
+    default:
+      opr = new Division(lefts[i], rights[i]);
+      break;
+    }
+    checksum += opr->perform();
+    delete opr;
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> object = end - start;
+  cout << "  one object per line: " << object.count() << " (" << checksum << ")" << endl;
+
+  checksum = 0;
+  start = chrono::high_resolution_clock::now();
+  OperationBatch batch;
+  batch.reserve(batchSize);
+  for (size_t first = 0; first < count; first += batchSize) {
+    size_t last = first + batchSize < count ? first + batchSize : count;
+    for (size_t i = first; i < last; i++) {
+      batch.add(ops[i], lefts[i], rights[i]);
+    }
+    batch.evaluate();
+    for (size_t i = 0; i < batch.size(); i++) {
+      checksum += batch.result(i);
+    }
+    batch.clear();
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> batched = end - start;
+  cout << "  batches of " << batchSize << ": " << batched.count() << " (" << checksum << ")"
+       << endl;
+}
+
+// writes a random operations file of about `bytes` bytes to `path`, like
+// operations-in.txt but with some decimals too; returns the number of lines
+static size_t generateOperationsFile(const char* path, size_t bytes) {
+  const char symbols[] = { '+', '-', '*', '/' };
+  mt19937 random(2420);
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    return 0;
+  }
+  size_t written = 0;
+  size_t lines = 0;
+  char line[64];
+  while (written < bytes) {
+    int length;
+    if (lines % 4 == 0) {
+      length = snprintf(line, sizeof(line), "%c %.3f %.2f\n", symbols[random() % 4],
+                        (random() % 2000000) / 1000.0 - 1000, (random() % 100000) / 100.0);
+    } else {
+      length = snprintf(line, sizeof(line), "%c %3u %3u\n", symbols[random() % 4],
+                        static_cast<unsigned>(random() % 100), static_cast<unsigned>(random() % 100));
+    }
+    fwrite(line, 1, length, file);
+    written += length;
+    lines++;
+  }
+  fclose(file);
+  return lines;
+}
+
+// times reading a generated operations file with `ifstream >>`, the way
+// `main()` used to, against `OperationReader`; both just add up what they read
+static void benchmarkReaders(const char* path, size_t lines, size_t inputMiB) {
+  cout << "Reading " << lines << " lines (" << inputMiB << " MiB), in milliseconds:" << endl;
+
+  char op;
+  double lhs;
+  double rhs;
+  double checksum = 0;
+  size_t count = 0;
+  auto start = chrono::high_resolution_clock::now();
+  ifstream in_f(path);
+  while (in_f >> op >> lhs >> rhs) {
+    checksum += lhs + rhs;
+    count++;
+  }
+  in_f.close();
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> extraction = end - start;
+  cout << "  ifstream >>: " << extraction.count() << " (" << count << " lines, " << checksum
+       << ")" << endl;
+
+  checksum = 0;
+  count = 0;
+  start = chrono::high_resolution_clock::now();
+  {
+    OperationReader reader(path);
+    LineStatus status;
+    while ((status = reader.next(op, lhs, rhs)) != LineStatus::End) {
+      if (status == LineStatus::Parsed) {
+        checksum += lhs + rhs;
+        count++;
+      }
+    }
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> reader = end - start;
+  cout << "  OperationReader: " << reader.count() << " (" << count << " lines, " << checksum
+       << ")" << endl;
+}
+
+// times writing a few million lines of output to two copies of /dev/null with
+// `<<`, the way `main()` used to write to `cout` and the output file, against
+// `OperationWriter`
+static void benchmarkWriters() {
+  const size_t count = 2000000;
+  mt19937 random(2420);
+  uniform_real_distribution<double> operand(-1000, 1000);
+  vector<double> lefts(count);
+  vector<double> rights(count);
+  for (size_t i = 0; i < count; i++) {
+    lefts[i] = operand(random);
+    rights[i] = operand(random);
+  }
+  cout << "Writing " << count << " lines to two sinks, in milliseconds:" << endl;
+
+  auto start = chrono::high_resolution_clock::now();
+  {
+    ofstream first("/dev/null");
+    ofstream second("/dev/null");
+    for (size_t i = 0; i < count; i++) {
+      printOperation(first, lefts[i], '*', rights[i], lefts[i] * rights[i]);
+      printOperation(second, lefts[i], '*', rights[i], lefts[i] * rights[i]);
+    }
+  }
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> streams = end - start;
+  cout << "  << with endl: " << streams.count() << endl;
+
+  int first = open("/dev/null", O_WRONLY);
+  int second = open("/dev/null", O_WRONLY);
+  start = chrono::high_resolution_clock::now();
+  {
+    OperationWriter writer;
+    writer.addSink(first);
+    writer.addSink(second);
+    for (size_t i = 0; i < count; i++) {
+      writer.write(lefts[i], '*', rights[i], lefts[i] * rights[i]);
+    }
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> buffered = end - start;
+  close(first);
+  close(second);
+  cout << "  OperationWriter: " << buffered.count() << endl;
+}
+
+// times the whole calculator, from reading the generated file to writing the
+// results to /dev/null, on this thread the way `./run` does it, and with the
+// pipeline on more and more threads the way `./run --threads N` does it
+static void benchmarkPipeline(const char* path, size_t lines) {
+  unsigned int cores = thread::hardware_concurrency() > 0 ? thread::hardware_concurrency() : 1;
+  cout << "Calculating " << lines << " lines with " << cores << " cores, in milliseconds:" << endl;
+  int out = open("/dev/null", O_WRONLY);
+
+  auto start = chrono::high_resolution_clock::now();
+  {
+    OperationWriter writer;
+    writer.addSink(out);
+    OperationReader reader(path);
+    OperationBatch batch;
+    char op;
+    double lhs;
+    double rhs;
+    LineStatus status;
+    while ((status = reader.next(op, lhs, rhs)) != LineStatus::End) {
+      batch.add(op, lhs, rhs);
+      if (batch.size() == 1 << 16) {
+        batch.evaluate();
+        batch.write(writer);
+        batch.clear();
+      }
+    }
+    batch.evaluate();
+    batch.write(writer);
+  }
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> serial = end - start;
+  cout << "  one thread, no pipeline: " << serial.count() << endl;
+
+  for (unsigned int threads = 1; threads <= cores * 2; threads *= 2) {
+    start = chrono::high_resolution_clock::now();
+    {
+      OperationWriter writer;
+      writer.addSink(out);
+      OperationPipeline pipeline(threads);
+      pipeline.run(path, writer, cerr);
+    }
+    end = chrono::high_resolution_clock::now();
+    chrono::duration<double, milli> piped = end - start;
+    cout << "  pipeline, " << threads << " worker(s): " << piped.count() << " (" << serial / piped
+         << "x)" << endl;
+  }
+  close(out);
+}
+
+// times dispatching on each operation's symbol, one at a time: with a
+// `switch` to pick an `Operation` subclass and a virtual `perform()`, with
+// `RegisteredOperation`, and with a single lookup in the operator registry
+static void benchmarkDispatch() {
+  const size_t count = 10000000;
+  const char symbols[] = { '+', '-', '*', '/', '%', '^', symbolNamed("min"), symbolNamed("max"),
+                           symbolNamed("hypot") };
+  mt19937 random(2420);
+  uniform_real_distribution<double> operand(1, 10);
+  vector<char> ops(count);
+  vector<double> lefts(count);
+  vector<double> rights(count);
+  for (size_t i = 0; i < count; i++) {
+    ops[i] = symbols[random() % 4];
+    lefts[i] = operand(random);
+    rights[i] = operand(random);
+  }
+  cout << "Dispatching " << count << " operations one at a time, in milliseconds:" << endl;
+
+  double checksum = 0;
+  auto start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    Operation* opr;
+    switch (ops[i]) {
+    case '+':
+      opr = new Addition(lefts[i], rights[i]);
+      break;
+    case '-':
+      opr = new Subtraction(lefts[i], rights[i]);
+      break;
+    case '*':
+      opr = new Multiplication(lefts[i], rights[i]);
+      break;
+    default:
+      opr = new Division(lefts[i], rights[i]);
+      break;
+    }
+    checksum += opr->perform();
+    delete opr;
+  }
+  auto end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> virtuals = end - start;
+  cout << "  switch and virtual perform(): " << virtuals.count() << " (" << checksum << ")" << endl;
+
+  checksum = 0;
+  start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    RegisteredOperation opr(ops[i], lefts[i], rights[i]);
+    const Operation& base = opr;
+    checksum += base.perform();
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> registered = end - start;
+  cout << "  RegisteredOperation: " << registered.count() << " (" << checksum << ")" << endl;
+
+  checksum = 0;
+  start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    checksum += operatorFor(ops[i]).apply(lefts[i], rights[i]);
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> table = end - start;
+  cout << "  registry lookup: " << table.count() << " (" << checksum << ")" << endl;
+
+  // the operators that only the registry has, so there's nothing to compare with
+  for (size_t i = 0; i < count; i++) {
+    ops[i] = symbols[4 + random() % 5];
+  }
+  checksum = 0;
+  start = chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    checksum += operatorFor(ops[i]).apply(lefts[i], rights[i]);
+  }
+  end = chrono::high_resolution_clock::now();
+  chrono::duration<double, milli> added = end - start;
+  cout << "  registry lookup, new operators: " << added.count() << " (" << checksum << ")" << endl;
+}
+
+void runBenchmarks(size_t inputMiB) {
+  benchmarkBatch();
+  benchmarkDispatch();
+  benchmarkWriters();
+
+  // the reading and pipeline benchmarks share one generated file
+  const char* path = "operations-bench.txt";
+  size_t lines = generateOperationsFile(path, inputMiB << 20);
+  if (lines == 0) {
+    cout << "Couldn't write " << path << ", skipping the reading benchmarks" << endl;
+    return;
+  }
+  benchmarkReaders(path, lines, inputMiB);
+  benchmarkPipeline(path, lines);
+  remove(path);
+}
@@ -0,0 +1,10 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+
+// runs the calculator benchmarks, for `./run --bench`; the reading benchmark
+// generates an input file about `inputMiB` MiB big
+void runBenchmarks(size_t inputMiB);
+
+#endif
@@ -1,68 +1,126 @@
-#include "addition.h"
-#include "division.h"
-#include "multiplication.h"
-#include "operation.h"
-#include "subtraction.h"
-#include <fstream>
-#include <iomanip>
+#include "benchmark.h"
+#include "operationbatch.h"
+#include "operationpipeline.h"
+#include "operationreader.h"
+#include "operationwriter.h"
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <unistd.h>
 using namespace std;
 
-int main(int argc, char const* argv[]) {
-  // file handles for input and output streams
-  ifstream in_f("operations-in.txt");
-  ofstream out_f("operations-out.txt");
+// how many lines are read before they're evaluated together
+const size_t BATCH_SIZE = 1 << 16;
 
-  // variables to store the tokens from each line in the input file
-  char op;
-  double lhs;
-  double rhs;
-  double res;
+// evaluates the operations read so far, writes them out, and empties the
+// batch for the next lines
+static void finishBatch(OperationBatch& batch, OperationWriter& writer) {
+  batch.evaluate();
+  batch.write(writer);
+  batch.clear();
+}
 
-  while (in_f >> op >> lhs >> rhs) {
+// reads all of `text` as a whole number into `value`; returns false if it
+// isn't one, or is too big for an `unsigned long`
+static bool parseCount(const char* text, unsigned long& value) {
+  const char* end = text + strlen(text);
+  from_chars_result result = from_chars(text, end, value);
+  return result.ec == errc() && result.ptr == end && result.ptr != text;
+}
 
-    // initialize objects
-    Addition* add = new Addition(lhs, rhs);
-    Subtraction* sub = new Subtraction(lhs, rhs);
-    Multiplication* mul = new Multiplication(lhs, rhs);
-    Division* div = new Division(lhs, rhs);
+static int usage() {
+  cerr << "usage: ./run [--threads N | --bench [MiB]]" << endl;
+  return 1;
+}
 
-    // based on the `op` token, representing the input line's operator
-    switch (op) {
-    // if it's a '+', then use the `add` object to write the output
-    case '+':
-      cout << *add;
-      out_f << *add;
-      break;
-    // if it's a '-', then use the `sub` object to write the output
-    case '-':
-      cout << *sub;
-      out_f << *sub;
-      break;
-    // if it's a '*', then use the `mul` object to write the output
-    case '*':
-      cout << *mul;
-      out_f << *mul;
-      break;
-    // if it's a '/', then use the `div` object to write the output
-    case '/':
-      cout << *div;
-      out_f << *div;
-      break;
-    default:
-      break;
+int main(int argc, char const* argv[]) {
+  // `./run --bench [MiB]` times the calculator instead of running it
+  if (argc > 1 && string(argv[1]) == "--bench") {
+    unsigned long mebibytes = 64;
+    if (argc > 2 && !parseCount(argv[2], mebibytes)) {
+      return usage();
     }
+    runBenchmarks(mebibytes);
+    return 0;
+  }
 
-    // clean up objects
-    delete add;
-    delete sub;
-    delete mul;
-    delete div;
+  // `./run --threads N` has N threads work on chunks of the input at once, or
+  // one per core for 0; otherwise it's all done on this thread; more than four
+  // per core wouldn't get through it any faster, so N is capped there
+  unsigned int threads = 1;
+  if (argc > 1 && string(argv[1]) == "--threads") {
+    unsigned long requested;
+    if (argc < 3 || !parseCount(argv[2], requested)) {
+      return usage();
+    }
+    unsigned long cores = thread::hardware_concurrency() > 0 ? thread::hardware_concurrency() : 1;
+    threads = requested < cores * 4 ? requested : cores * 4;
+  }
+
+  // the input is read a block at a time rather than through an `ifstream`;
+  // the output file is only created once the input is known to be there
+  OperationReader reader("operations-in.txt");
+  if (!reader.isOpen()) {
+    cerr << "couldn't open operations-in.txt" << endl;
+    return 1;
+  }
+  int out_fd = open("operations-out.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out_fd < 0) {
+    cerr << "couldn't open operations-out.txt" << endl;
+    return 1;
+  }
+
+  // each line goes to both the console and the output file, formatted once and
+  // written a buffer at a time
+  OperationWriter writer;
+  writer.addSink(STDOUT_FILENO);
+  writer.addSink(out_fd);
+
+  // a line that can't be read, or output that can't be written, stops the run
+  // on every thread; a sink that fails doesn't stop the others, so the output
+  // file is still written in full if just the console fails; read errors name
+  // the input file themselves, so nothing is added to what they say
+  try {
+    if (threads != 1) {
+      OperationPipeline pipeline(threads);
+      pipeline.run("operations-in.txt", writer, cerr);
+    } else {
+      // variables to store the tokens from each line in the input file
+      char op;
+      double lhs;
+      double rhs;
+
+      // the lines are evaluated a batch at a time, grouped by operator, rather
+      // than one `Operation` object at a time; lines with an unknown operator
+      // are skipped, and lines that can't be read are reported and skipped
+      OperationBatch batch;
+      batch.reserve(BATCH_SIZE);
+      LineStatus status;
+      while ((status = reader.next(op, lhs, rhs)) != LineStatus::End) {
+        if (status == LineStatus::Malformed) {
+          cerr << "operations-in.txt:" << reader.lineNumber()
+               << ": skipping malformed line: " << reader.lineText() << endl;
+          continue;
+        }
+        batch.add(op, lhs, rhs);
+        if (batch.size() == BATCH_SIZE) {
+          finishBatch(batch, writer);
+        }
+      }
+      finishBatch(batch, writer);
+    }
+    writer.flush();
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    close(out_fd);
+    return 1;
   }
 
-  // clean up file handless
-  in_f.close();
-  out_f.close();
+  // clean up file handles
+  close(out_fd);
   return 0;
 }
@@ -1,4 +1,5 @@
 #include "operation.h"
+#include "operatorregistry.h"
 #include <iomanip>
 #include <ostream>
 using namespace std;
@@ -14,8 +15,14 @@ Operation::~Operation() {}
 // or perhaps the implementation shouldn't be in the individual classes and
 // should only be here?
 ostream& operator<<(ostream& out, const Operation& opr) {
+  return printOperation(out, opr.left, opr.symbol(), opr.right, opr.perform());
+}
+
+// writes a formatted line of output for an operation; an operator written as
+// a word is written out as that word
+ostream& printOperation(ostream& out, double left, char symbol, double right, double result) {
   out << setprecision(2) << fixed;
-  out << setw(5) << opr.left << setw(2) << opr.symbol() << setw(9) << opr.right
-      << setw(2) << "=" << setw(11) << opr.perform() << endl;
+  out << setw(5) << left << ' ' << spellingOf(symbol) << setw(9) << right << setw(2) << "="
+      << setw(11) << result << endl;
   return out;
 }
\ No newline at end of file
@@ -19,4 +19,8 @@ public:
   friend ostream& operator<<(ostream& out, const Operation& opr);
 };
 
+// writes one line of output for `left symbol right = result`, in the same
+// format as `<<` on an `Operation`
+ostream& printOperation(ostream& out, double left, char symbol, double right, double result);
+
 #endif
\ No newline at end of file
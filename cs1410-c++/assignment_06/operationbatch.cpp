@@ -0,0 +1,103 @@
+#include "operationbatch.h"
+#include "operatorregistry.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// returns whether `op` is an operator a batch can evaluate
+bool OperationBatch::supports(char op) { return isOperator(op); }
+
+// adds an operation to the end of the batch; it isn't evaluated until `evaluate()`
+void OperationBatch::add(char op, double left, double right) {
+  this->ops.push_back(op);
+  this->lefts.push_back(left);
+  this->rights.push_back(right);
+}
+// makes room for `n` operations without allocating again
+void OperationBatch::reserve(size_t n) {
+  this->ops.reserve(n);
+  this->lefts.reserve(n);
+  this->rights.reserve(n);
+  this->results.reserve(n);
+}
+// empties the batch, keeping its memory for the next one
+void OperationBatch::clear() {
+  this->ops.clear();
+  this->lefts.clear();
+  this->rights.clear();
+  this->results.clear();
+}
+// returns the number of operations in the batch
+size_t OperationBatch::size() const { return this->ops.size(); }
+
+// evaluates every operation in the batch; the operands are sorted into one
+// group per operator, each group is evaluated by its kernel from the operator
+// registry, and the results are put back in the original order; operations
+// with an unknown operator get NaN
+void OperationBatch::evaluate() {
+  size_t n = this->ops.size();
+  this->results.assign(n, NAN);
+  this->order.resize(n);
+  this->groupLefts.resize(n);
+  this->groupRights.resize(n);
+  this->groupResults.resize(n);
+
+  // count the operations with each operator, to find where each group starts
+  size_t starts[257] = {};
+  for (char op : this->ops) {
+    starts[static_cast<unsigned char>(op) + 1]++;
+  }
+  for (int c = 0; c < 256; c++) {
+    starts[c + 1] += starts[c];
+  }
+
+  // copy the operands into their groups, remembering where each one came from
+  size_t next[256];
+  copy(starts, starts + 256, next);
+  for (size_t i = 0; i < n; i++) {
+    size_t slot = next[static_cast<unsigned char>(this->ops[i])]++;
+    this->order[slot] = i;
+    this->groupLefts[slot] = this->lefts[i];
+    this->groupRights[slot] = this->rights[i];
+  }
+
+  for (int c = 0; c < 256; c++) {
+    const Operator& opr = operatorFor(static_cast<char>(c));
+    size_t begin = starts[c];
+    size_t end = starts[c + 1];
+    if (opr.name == nullptr || begin == end) {
+      continue;
+    }
+    opr.applyAll(&this->groupLefts[begin], &this->groupRights[begin], &this->groupResults[begin],
+                 end - begin);
+    for (size_t slot = begin; slot < end; slot++) {
+      this->results[this->order[slot]] = this->groupResults[slot];
+    }
+  }
+}
+
+// getters for the `i`th operation; `result()` is only there after `evaluate()`
+char OperationBatch::op(size_t i) const { return this->ops[i]; }
+double OperationBatch::left(size_t i) const { return this->lefts[i]; }
+double OperationBatch::right(size_t i) const { return this->rights[i]; }
+double OperationBatch::result(size_t i) const { return this->results[i]; }
+
+// writes each evaluated operation, in order, to an `OperationWriter`, the same
+// way `<<` on an `Operation` would; ones with an unknown operator are left out
+void OperationBatch::write(OperationWriter& out) const {
+  for (size_t i = 0; i < this->ops.size(); i++) {
+    if (supports(this->ops[i])) {
+      out.write(this->lefts[i], this->ops[i], this->rights[i], this->results[i]);
+    }
+  }
+}
+// appends each evaluated operation, in order, to `out`, formatted the same way
+void OperationBatch::write(vector<char>& out) const {
+  char line[MAX_OPERATION_LINE];
+  for (size_t i = 0; i < this->ops.size(); i++) {
+    if (supports(this->ops[i])) {
+      char* end = formatOperation(line, this->lefts[i], this->ops[i], this->rights[i], this->results[i]);
+      out.insert(out.end(), line, end);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef OPERATIONBATCH_H
+#define OPERATIONBATCH_H
+
+#include "operationwriter.h"
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// a batch of operations, kept as one array per field instead of one object per
+// operation, so that all the operations with the same operator can be
+// evaluated together in one simple loop
+class OperationBatch {
+private:
+  vector<char> ops;
+  vector<double> lefts;
+  vector<double> rights;
+  vector<double> results;
+
+  // scratch space for `evaluate()`, kept to be reused by the next batch
+  vector<size_t> order;
+  vector<double> groupLefts;
+  vector<double> groupRights;
+  vector<double> groupResults;
+
+public:
+  static bool supports(char op);
+
+  void add(char op, double left, double right);
+  void reserve(size_t n);
+  void clear();
+  size_t size() const;
+
+  void evaluate();
+  char op(size_t i) const;
+  double left(size_t i) const;
+  double right(size_t i) const;
+  double result(size_t i) const;
+
+  void write(OperationWriter& out) const;
+  void write(vector<char>& out) const;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "operationpipeline.h"
+#include "operationbatch.h"
+#include "operationreader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+using namespace std;
+
+// constructor: `threads` workers, or one per core if it's 0, each taking
+// about `chunkKiB` KiB of the file at a time
+OperationPipeline::OperationPipeline(unsigned int threads, size_t chunkKiB) {
+  this->threads = threads > 0 ? threads : thread::hardware_concurrency();
+  if (this->threads == 0) {
+    this->threads = 1;
+  }
+  this->chunkSize = chunkKiB > 0 ? chunkKiB * 1024 : 1024;
+}
+
+// fills `chunk` with the next run of whole lines, about `chunkSize` bytes of
+// them, starting with whatever was left over after the last one; returns false
+// once the file is done
+bool OperationPipeline::readChunk(Chunk& chunk) {
+  if (chunk.input.size() < this->chunkSize + this->carry.size()) {
+    chunk.input.resize(this->chunkSize + this->carry.size());
+  }
+  size_t length = this->carry.size();
+  if (length > 0) {
+    memcpy(chunk.input.data(), this->carry.data(), length);
+    this->carry.clear();
+  }
+
+  while (true) {
+    while (length < chunk.input.size() && !this->atEnd) {
+      ssize_t count = read(this->fd, chunk.input.data() + length, chunk.input.size() - length);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw system_error(errno, generic_category(), this->path + ": reading failed");
+      }
+      if (count == 0) {
+        this->atEnd = true;
+      }
+      length += count;
+    }
+    if (this->atEnd) {
+      break;
+    }
+    // cut after the last line break; the partial line after it starts the next chunk
+    size_t cut = length;
+    while (cut > 0 && chunk.input[cut - 1] != '\n') {
+      cut--;
+    }
+    if (cut > 0) {
+      this->carry.assign(chunk.input.begin() + cut, chunk.input.begin() + length);
+      length = cut;
+      break;
+    }
+    // a single line longer than the whole chunk
+    chunk.input.resize(chunk.input.size() * 2);
+  }
+  chunk.length = length;
+  return length > 0;
+}
+
+// the reading thread: reads chunks into the ring, in order, waiting whenever
+// it's full for the writer to empty the next slot
+void OperationPipeline::readAll() {
+  try {
+    for (size_t index = 0;; index++) {
+      Chunk& chunk = this->chunks[index % this->chunks.size()];
+      {
+        unique_lock<mutex> guard(this->lock);
+        this->chunkEmptied.wait(guard, [&] {
+          return chunk.state == ChunkState::Empty || this->abandoned;
+        });
+        if (this->abandoned) {
+          break;
+        }
+      }
+      if (!this->readChunk(chunk)) {
+        break;
+      }
+      {
+        lock_guard<mutex> guard(this->lock);
+        chunk.state = ChunkState::Read;
+        this->readCount = index + 1;
+      }
+      this->chunkRead.notify_one();
+    }
+  } catch (...) {
+    lock_guard<mutex> guard(this->lock);
+    this->readError = current_exception();
+  }
+  {
+    lock_guard<mutex> guard(this->lock);
+    this->readingDone = true;
+  }
+  this->chunkRead.notify_all();
+  this->chunkDone.notify_all();
+}
+
+// parses, evaluates and formats the lines of one chunk; malformed lines are
+// kept, numbered from the start of the chunk, for the writer to report
+void OperationPipeline::process(Chunk& chunk) {
+  // each thread keeps its own batch, so its memory is reused from chunk to chunk
+  thread_local OperationBatch batch;
+  chunk.output.clear();
+  chunk.malformed.clear();
+  chunk.lines = 0;
+
+  char op;
+  double lhs;
+  double rhs;
+  const char* p = chunk.input.data();
+  const char* end = p + chunk.length;
+  while (p < end) {
+    const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+    const char* lineEnd = newline != nullptr ? newline : end;
+    chunk.lines++;
+    string_view line(p, lineEnd - p);
+    LineStatus status = parseOperationLine(line, op, lhs, rhs);
+    if (status == LineStatus::Parsed) {
+      batch.add(op, lhs, rhs);
+    } else if (status == LineStatus::Malformed) {
+      chunk.malformed.emplace_back(chunk.lines, string(line));
+    }
+    p = newline != nullptr ? newline + 1 : end;
+  }
+  batch.evaluate();
+  batch.write(chunk.output);
+  batch.clear();
+}
+
+// a worker thread: takes the chunks in the order they were read, and marks
+// each one done once it's processed; if processing fails, the error is kept
+// and everyone else is told to stop, the same as when writing fails
+void OperationPipeline::work() {
+  while (true) {
+    size_t index;
+    {
+      unique_lock<mutex> guard(this->lock);
+      this->chunkRead.wait(guard, [&] {
+        return this->takenCount < this->readCount || this->readingDone || this->abandoned;
+      });
+      if (this->abandoned || this->takenCount == this->readCount) {
+        return;
+      }
+      index = this->takenCount++;
+    }
+    Chunk& chunk = this->chunks[index % this->chunks.size()];
+    try {
+      process(chunk);
+    } catch (...) {
+      {
+        lock_guard<mutex> guard(this->lock);
+        if (!this->workError) {
+          this->workError = current_exception();
+        }
+        this->abandoned = true;
+      }
+      this->chunkEmptied.notify_all();
+      this->chunkRead.notify_all();
+      this->chunkDone.notify_all();
+      return;
+    }
+    {
+      lock_guard<mutex> guard(this->lock);
+      chunk.state = ChunkState::Done;
+    }
+    this->chunkDone.notify_one();
+  }
+}
+
+// evaluates the operations file at `path`, writing the results to `writer` in
+// the order of the lines they came from, and reporting malformed lines to
+// `errors`; returns false if the file can't be opened
+bool OperationPipeline::run(const string& path, OperationWriter& writer, ostream& errors) {
+  this->fd = open(path.c_str(), O_RDONLY);
+  if (this->fd < 0) {
+    return false;
+  }
+  this->path = path;
+  this->atEnd = false;
+  this->carry.clear();
+  // two chunks per worker is enough to keep them all busy while the writer catches up
+  this->chunks = vector<Chunk>(this->threads * 2 + 1);
+  this->readCount = 0;
+  this->takenCount = 0;
+  this->readingDone = false;
+  this->readError = nullptr;
+  this->workError = nullptr;
+  this->abandoned = false;
+
+  thread reader(&OperationPipeline::readAll, this);
+  vector<thread> workers;
+  for (unsigned int i = 0; i < this->threads; i++) {
+    workers.emplace_back(&OperationPipeline::work, this);
+  }
+
+  // this thread is the reorder buffer: it waits for the next chunk in line,
+  // however many after it are already done; if writing fails, the reader and
+  // workers are told to stop so the threads can be joined before the error goes on
+  exception_ptr writeError;
+  try {
+    size_t linesBefore = 0;
+    for (size_t index = 0;; index++) {
+      Chunk& chunk = this->chunks[index % this->chunks.size()];
+      {
+        unique_lock<mutex> guard(this->lock);
+        this->chunkDone.wait(guard, [&] {
+          return chunk.state == ChunkState::Done ||
+                 (this->readingDone && index == this->readCount) || this->abandoned;
+        });
+        if (this->abandoned || chunk.state != ChunkState::Done) {
+          break;
+        }
+      }
+      for (const pair<size_t, string>& line : chunk.malformed) {
+        errors << path << ":" << linesBefore + line.first
+               << ": skipping malformed line: " << line.second << endl;
+      }
+      writer.writeLines(chunk.output.data(), chunk.output.size());
+      linesBefore += chunk.lines;
+      {
+        lock_guard<mutex> guard(this->lock);
+        chunk.state = ChunkState::Empty;
+      }
+      this->chunkEmptied.notify_one();
+    }
+  } catch (...) {
+    writeError = current_exception();
+    {
+      lock_guard<mutex> guard(this->lock);
+      this->abandoned = true;
+    }
+    this->chunkEmptied.notify_all();
+    this->chunkRead.notify_all();
+  }
+
+  reader.join();
+  for (thread& worker : workers) {
+    worker.join();
+  }
+  close(this->fd);
+  this->chunks.clear();
+  if (writeError) {
+    rethrow_exception(writeError);
+  }
+  if (this->workError) {
+    rethrow_exception(this->workError);
+  }
+  if (this->readError) {
+    rethrow_exception(this->readError);
+  }
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef OPERATIONPIPELINE_H
+#define OPERATIONPIPELINE_H
+
+#include "operationwriter.h"
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// evaluates an operations file on several threads: one thread reads it in
+// chunks cut at line breaks, the workers parse, evaluate and format a chunk
+// each, and the calling thread writes the chunks out in their original order;
+// only a few chunks are ever held at once, so memory stays the same however
+// big the file is
+class OperationPipeline {
+private:
+  enum class ChunkState { Empty, Read, Done };
+
+  // one slot of the ring of chunks in flight, reused for every chunk that lands in it
+  struct Chunk {
+    vector<char> input;
+    size_t length = 0;
+    vector<char> output;
+    size_t lines = 0;
+    vector<pair<size_t, string>> malformed;
+    ChunkState state = ChunkState::Empty;
+  };
+
+  unsigned int threads;
+  size_t chunkSize;
+  vector<Chunk> chunks;
+
+  string path;
+  int fd;
+  bool atEnd;
+  vector<char> carry;
+
+  mutex lock;
+  condition_variable chunkEmptied;
+  condition_variable chunkRead;
+  condition_variable chunkDone;
+  size_t readCount;
+  size_t takenCount;
+  bool readingDone;
+  bool abandoned;
+  exception_ptr readError;
+  exception_ptr workError;
+
+  bool readChunk(Chunk& chunk);
+  void readAll();
+  void work();
+  static void process(Chunk& chunk);
+
+public:
+  explicit OperationPipeline(unsigned int threads, size_t chunkKiB = 4096);
+
+  bool run(const string& path, OperationWriter& writer, ostream& errors);
+};
+
+#endif
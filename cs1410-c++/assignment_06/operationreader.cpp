@@ -0,0 +1,151 @@
+#include "operationreader.h"
+#include "operatorregistry.h"
+#include <cerrno>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+using namespace std;
+
+// returns `p` moved past any whitespace
+static const char* skipSpace(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) {
+    p++;
+  }
+  return p;
+}
+
+// reads a number starting at `p` into `value`, returning where it ended, or
+// `nullptr` if there isn't a whole number there; a leading '+' is allowed,
+// like `>>` allows it
+static const char* parseNumber(const char* p, const char* end, double& value) {
+  if (p < end && *p == '+' && p + 1 < end && p[1] != '-') {
+    p++;
+  }
+  from_chars_result parsed = from_chars(p, end, value);
+  if (parsed.ec != errc() || (parsed.ptr < end && skipSpace(parsed.ptr, end) == parsed.ptr)) {
+    return nullptr;
+  }
+  return parsed.ptr;
+}
+
+LineStatus parseOperationLine(string_view line, char& op, double& lhs, double& rhs) {
+  const char* p = line.data();
+  const char* end = p + line.size();
+  p = skipSpace(p, end);
+  if (p == end) {
+    return LineStatus::Blank;
+  }
+  // like `>> op`, the operator is just the first character, so `+20 11` is
+  // fine; a word of more than one letter is the name of one, like `min`, and
+  // that's the only way to write those
+  const char* word = p;
+  while (p < end && isalpha(static_cast<unsigned char>(*p))) {
+    p++;
+  }
+  if (p - word > 1) {
+    op = symbolNamed(string_view(word, p - word));
+    if (op == '\0') {
+      return LineStatus::Malformed;
+    }
+  } else {
+    // a word operator's symbol on its own is an unknown operator, like any other
+    op = isNamedOperator(*word) ? '\0' : *word;
+    p = word + 1;
+  }
+  p = parseNumber(skipSpace(p, end), end, lhs);
+  if (p == nullptr) {
+    return LineStatus::Malformed;
+  }
+  p = parseNumber(skipSpace(p, end), end, rhs);
+  if (p == nullptr || skipSpace(p, end) != end) {
+    return LineStatus::Malformed;
+  }
+  return LineStatus::Parsed;
+}
+
+// constructor: opens `path`, to be read `blockSize` bytes at a time
+OperationReader::OperationReader(const string& path, size_t blockSize)
+    : path(path), buffer(blockSize), begin(0), end(0), atEnd(false), line(0) {
+  this->fd = open(path.c_str(), O_RDONLY);
+}
+// destructor: closes the file
+OperationReader::~OperationReader() {
+  if (this->fd >= 0) {
+    close(this->fd);
+  }
+}
+
+// returns whether the file could be opened
+bool OperationReader::isOpen() const { return this->fd >= 0; }
+
+// moves the unread part of the block to the front, and reads more after it,
+// growing the buffer if a single line filled all of it; returns false once
+// there's nothing more to read
+bool OperationReader::fill() {
+  if (this->atEnd || this->fd < 0) {
+    return false;
+  }
+  if (this->begin > 0) {
+    memmove(this->buffer.data(), this->buffer.data() + this->begin, this->end - this->begin);
+    this->end -= this->begin;
+    this->begin = 0;
+  }
+  if (this->end == this->buffer.size()) {
+    this->buffer.resize(this->buffer.size() * 2);
+  }
+  ssize_t count;
+  do {
+    count = read(this->fd, this->buffer.data() + this->end, this->buffer.size() - this->end);
+  } while (count < 0 && errno == EINTR);
+  if (count < 0) {
+    throw system_error(errno, generic_category(), this->path + ": reading failed");
+  }
+  if (count == 0) {
+    this->atEnd = true;
+    return false;
+  }
+  this->end += count;
+  return true;
+}
+
+// reads the next line that isn't blank into `op`, `lhs` and `rhs`; returns
+// `Malformed` for a line that can't be parsed, so it can be reported and
+// skipped, and `End` once the file is done
+LineStatus OperationReader::next(char& op, double& lhs, double& rhs) {
+  while (true) {
+    const char* start = this->buffer.data() + this->begin;
+    const char* newline = static_cast<const char*>(memchr(start, '\n', this->end - this->begin));
+    if (newline == nullptr) {
+      if (this->fill()) {
+        continue;
+      }
+      if (this->begin == this->end) {
+        return LineStatus::End;
+      }
+      // the last line doesn't have to end with a newline; `fill()` may have
+      // moved it to the front
+      start = this->buffer.data() + this->begin;
+      newline = this->buffer.data() + this->end;
+    }
+    this->current = string_view(start, newline - start);
+    this->begin = newline - this->buffer.data();
+    if (this->begin < this->end) {
+      this->begin++;
+    }
+    this->line++;
+
+    LineStatus status = parseOperationLine(this->current, op, lhs, rhs);
+    if (status != LineStatus::Blank) {
+      return status;
+    }
+  }
+}
+
+// returns the number of the line `next()` last read, counting from 1
+size_t OperationReader::lineNumber() const { return this->line; }
+// returns the text of the line `next()` last read; it's only good until the next call
+string_view OperationReader::lineText() const { return this->current; }
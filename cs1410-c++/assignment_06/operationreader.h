@@ -0,0 +1,46 @@
+#ifndef OPERATIONREADER_H
+#define OPERATIONREADER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// what reading or parsing a line of operations found
+enum class LineStatus { Parsed, Blank, Malformed, End };
+
+// parses one line of the form `op lhs rhs`, e.g. `+ 20 11` or `max 20 11`; a
+// line that's empty or all whitespace is `Blank`, and one with a missing,
+// extra or unreadable token, or an operator name that isn't registered, is
+// `Malformed`
+LineStatus parseOperationLine(string_view line, char& op, double& lhs, double& rhs);
+
+// reads an operations file a large block at a time, and parses it a line at a
+// time straight out of the block, without going through an `istream`
+class OperationReader {
+private:
+  string path;
+  int fd;
+  vector<char> buffer;
+  size_t begin;
+  size_t end;
+  bool atEnd;
+  size_t line;
+  string_view current;
+
+  bool fill();
+
+public:
+  explicit OperationReader(const string& path, size_t blockSize = 1 << 20);
+  OperationReader(const OperationReader& reader) = delete;
+  OperationReader& operator=(const OperationReader& reader) = delete;
+  ~OperationReader();
+
+  bool isOpen() const;
+  LineStatus next(char& op, double& lhs, double& rhs);
+  size_t lineNumber() const;
+  string_view lineText() const;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "operationwriter.h"
+#include "operatorregistry.h"
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+using namespace std;
+
+// writes `text` right-aligned in a field `width` characters wide, like `setw()`
+static char* padded(char* out, size_t width, const char* text, size_t length) {
+  if (length < width) {
+    memset(out, ' ', width - length);
+    out += width - length;
+  }
+  memcpy(out, text, length);
+  return out + length;
+}
+// writes `value` with two decimal places, like `fixed` and `setprecision(2)`,
+// right-aligned in a field `width` characters wide
+static char* paddedNumber(char* out, size_t width, double value) {
+  // the longest a double gets in fixed notation is 309 digits, a sign, a
+  // point and two decimals
+  char digits[320];
+  to_chars_result result = to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, 2);
+  return padded(out, width, digits, result.ptr - digits);
+}
+
+// writes all `length` bytes at `text` to `fd`, however many `write()` calls it takes
+static void writeAll(int fd, const char* text, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, text, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw system_error(errno, generic_category(), "OperationWriter: writing failed");
+    }
+    text += written;
+    length -= written;
+  }
+}
+
+char* formatOperation(char* out, double left, char symbol, double right, double result) {
+  out = paddedNumber(out, 5, left);
+  // a space and the symbol, or the word for one written as a word
+  string_view spelling = spellingOf(symbol);
+  out = padded(out, spelling.size() + 1, spelling.data(), spelling.size());
+  out = paddedNumber(out, 9, right);
+  out = padded(out, 2, "=", 1);
+  out = paddedNumber(out, 11, result);
+  *out++ = '\n';
+  return out;
+}
+
+// constructor: nothing is written until there are `bufferKiB` KiB of lines, or `flush()`
+OperationWriter::OperationWriter(size_t bufferKiB)
+    : buffer(bufferKiB * 1024 > MAX_OPERATION_LINE ? bufferKiB * 1024 : MAX_OPERATION_LINE),
+      used(0) {}
+// destructor: writes out whatever is left; there's no one to tell if that
+// fails, so errors are dropped
+OperationWriter::~OperationWriter() {
+  try {
+    this->flush();
+  } catch (...) {
+  }
+}
+
+// adds a file descriptor for every line to be written to; the writer doesn't close it
+void OperationWriter::addSink(int fd) { this->sinks.push_back(fd); }
+
+// adds a line for `left symbol right = result`
+void OperationWriter::write(double left, char symbol, double right, double result) {
+  if (this->buffer.size() - this->used < MAX_OPERATION_LINE) {
+    this->writeToSinks(this->buffer.data(), this->used);
+    this->used = 0;
+  }
+  char* end = formatOperation(this->buffer.data() + this->used, left, symbol, right, result);
+  this->used = end - this->buffer.data();
+}
+
+// adds lines that are already formatted; if they don't fit in what's left of
+// the buffer, they're written straight to the sinks instead of being copied
+void OperationWriter::writeLines(const char* lines, size_t length) {
+  if (this->buffer.size() - this->used >= length) {
+    memcpy(this->buffer.data() + this->used, lines, length);
+    this->used += length;
+    return;
+  }
+  this->writeToSinks(this->buffer.data(), this->used);
+  this->used = 0;
+  this->writeToSinks(lines, length);
+}
+
+// writes `length` bytes at `lines` to every sink; one that fails is dropped,
+// and its error kept for `flush()`, unless it was the last one
+void OperationWriter::writeToSinks(const char* lines, size_t length) {
+  for (size_t i = 0; i < this->sinks.size();) {
+    try {
+      writeAll(this->sinks[i], lines, length);
+      i++;
+    } catch (...) {
+      if (!this->error) {
+        this->error = current_exception();
+      }
+      this->sinks.erase(this->sinks.begin() + i);
+    }
+  }
+  if (this->sinks.empty() && this->error) {
+    rethrow_exception(this->error);
+  }
+}
+
+// writes the buffered lines to every sink, and empties the buffer; throws the
+// first error any sink has had
+void OperationWriter::flush() {
+  this->writeToSinks(this->buffer.data(), this->used);
+  this->used = 0;
+  if (this->error) {
+    rethrow_exception(this->error);
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef OPERATIONWRITER_H
+#define OPERATIONWRITER_H
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+using namespace std;
+
+// writes lines of output for operations, in the same format as `<<` on an
+// `Operation`, to any number of file descriptors; the lines are formatted into
+// one buffer that is reused, and each time it fills up it goes to every sink
+// in a single `write()` apiece; a sink that fails is dropped and the rest are
+// still written to, and the first error is thrown by `flush()`, or as soon as
+// there are no sinks left
+class OperationWriter {
+private:
+  vector<char> buffer;
+  size_t used;
+  vector<int> sinks;
+  exception_ptr error;
+
+  void writeToSinks(const char* lines, size_t length);
+
+public:
+  explicit OperationWriter(size_t bufferKiB = 64);
+  OperationWriter(const OperationWriter& writer) = delete;
+  OperationWriter& operator=(const OperationWriter& writer) = delete;
+  ~OperationWriter();
+
+  void addSink(int fd);
+  void write(double left, char symbol, double right, double result);
+  void writeLines(const char* lines, size_t length);
+  void flush();
+};
+
+// formats one line for `left symbol right = result` at `out`, which needs room
+// for `MAX_OPERATION_LINE` characters, and returns where the line ends
+const size_t MAX_OPERATION_LINE = 1024;
+char* formatOperation(char* out, double left, char symbol, double right, double result);
+
+#endif
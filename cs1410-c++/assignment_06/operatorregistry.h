@@ -0,0 +1,121 @@
+#ifndef OPERATORREGISTRY_H
+#define OPERATORREGISTRY_H
+
+#include <cmath>
+#include <cstddef>
+#include <string_view>
+using namespace std;
+
+// an operator: how it's written in the input and output, which is either its
+// symbol or a word standing in for it, and its kernels, for one pair of operands and for
+// many at once
+struct Operator {
+  const char* name;
+  double (*apply)(double left, double right);
+  void (*applyAll)(const double* lefts, const double* rights, double* results, size_t n);
+};
+
+// every operator, indexed by its symbol, so finding one is a single lookup
+struct OperatorTable {
+  Operator entries[256];
+};
+
+// the kernels for one pair of operands
+inline double addOperands(double left, double right) { return left + right; }
+inline double subtractOperands(double left, double right) { return left - right; }
+inline double multiplyOperands(double left, double right) { return left * right; }
+inline double divideOperands(double left, double right) { return left / right; }
+inline double remainderOfOperands(double left, double right) { return fmod(left, right); }
+inline double powerOfOperands(double left, double right) { return pow(left, right); }
+inline double minOfOperands(double left, double right) { return left < right ? left : right; }
+inline double maxOfOperands(double left, double right) { return left > right ? left : right; }
+inline double hypotOfOperands(double left, double right) { return hypot(left, right); }
+// what a symbol that isn't an operator evaluates to
+inline double notAnOperator(double, double) { return NAN; }
+
+// applies `Apply` to `n` pairs of operands; since `Apply` is known at compile
+// time it's inlined, so the loop is as simple as writing it out by hand
+template <double (*Apply)(double, double)>
+void applyToAll(const double* lefts, const double* rights, double* results, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    results[i] = Apply(lefts[i], rights[i]);
+  }
+}
+
+template <double (*Apply)(double, double)>
+constexpr Operator makeOperator(const char* name) {
+  return Operator{ name, Apply, applyToAll<Apply> };
+}
+
+// builds the table at compile time; adding an operator takes just a kernel
+// above and a line here
+constexpr OperatorTable makeOperatorTable() {
+  OperatorTable table{};
+  for (Operator& entry : table.entries) {
+    entry = makeOperator<notAnOperator>(nullptr);
+  }
+  table.entries['+'] = makeOperator<addOperands>("+");
+  table.entries['-'] = makeOperator<subtractOperands>("-");
+  table.entries['*'] = makeOperator<multiplyOperands>("*");
+  table.entries['/'] = makeOperator<divideOperands>("/");
+  table.entries['%'] = makeOperator<remainderOfOperands>("%");
+  table.entries['^'] = makeOperator<powerOfOperands>("^");
+  // operators written as a word are kept under a control character, which
+  // no one types, rather than a letter, so `m 3 4` is still an unknown operator
+  table.entries['\x01'] = makeOperator<minOfOperands>("min");
+  table.entries['\x02'] = makeOperator<maxOfOperands>("max");
+  table.entries['\x03'] = makeOperator<hypotOfOperands>("hypot");
+  return table;
+}
+
+inline constexpr OperatorTable OPERATORS = makeOperatorTable();
+
+// every character as a string of its own, so how a symbol is written out can
+// point somewhere that outlives the symbol
+struct SymbolSpellings {
+  char text[256][2];
+};
+
+constexpr SymbolSpellings makeSymbolSpellings() {
+  SymbolSpellings spellings{};
+  for (int c = 0; c < 256; c++) {
+    spellings.text[c][0] = static_cast<char>(c);
+  }
+  return spellings;
+}
+
+inline constexpr SymbolSpellings SYMBOL_SPELLINGS = makeSymbolSpellings();
+
+// returns the operator for `symbol`; one that isn't an operator still has
+// kernels, which give NaN, so it can be called without checking first
+inline const Operator& operatorFor(char symbol) {
+  return OPERATORS.entries[static_cast<unsigned char>(symbol)];
+}
+// returns whether `symbol` is an operator
+inline bool isOperator(char symbol) { return operatorFor(symbol).name != nullptr; }
+// returns whether `symbol` is where an operator written as a word is kept, so
+// that it can only be written as that word
+inline bool isNamedOperator(char symbol) {
+  return isOperator(symbol) && operatorFor(symbol).name[1] != '\0';
+}
+// returns how `symbol` is written out: the word for an operator written as
+// one, otherwise the character itself; either way the view is into a table
+// that's never freed, so it can be kept
+inline string_view spellingOf(char symbol) {
+  if (isNamedOperator(symbol)) {
+    return operatorFor(symbol).name;
+  }
+  return string_view(SYMBOL_SPELLINGS.text[static_cast<unsigned char>(symbol)], 1);
+}
+// returns the symbol for the operator written as `name`, or '\0' if there isn't one
+constexpr char symbolNamed(string_view name) {
+  for (int c = 0; c < 256; c++) {
+    const char* entryName = OPERATORS.entries[c].name;
+    if (entryName != nullptr && name == entryName) {
+      return static_cast<char>(c);
+    }
+  }
+  return '\0';
+}
+
+#endif
@@ -0,0 +1,13 @@
+#include "registeredoperation.h"
+#include "operation.h"
+#include "operatorregistry.h"
+#include <ostream>
+using namespace std;
+
+// constructor
+RegisteredOperation::RegisteredOperation(char op, double l, double r) : Operation(l, r), op(op) {}
+// destructor
+RegisteredOperation::~RegisteredOperation() {}
+
+double RegisteredOperation::perform() const { return operatorFor(op).apply(left, right); }
+char RegisteredOperation::symbol() const { return op; }
@@ -0,0 +1,22 @@
+#ifndef REGISTEREDOPERATION_H
+#define REGISTEREDOPERATION_H
+
+#include "operation.h"
+#include <ostream>
+using namespace std;
+
+// an operation for any operator in the operator registry, so a new operator
+// doesn't need a class of its own
+class RegisteredOperation : public Operation {
+private:
+  char op;
+
+public:
+  RegisteredOperation(char op, double l, double r);
+  ~RegisteredOperation();
+
+  double perform() const;
+  char symbol() const;
+};
+
+#endif